@@ -5,11 +5,27 @@
  */
 
 #include <cctype>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fstream>
 #include <iostream>
 #include <string>
+#include <string_view>
+#include "arena.hpp"
+#include "batch.hpp"
+#include "emitter.hpp"
 #include "exp.hpp"
+#include "inputdata.hpp"
+#include "keyword.hpp"
+#include "output.hpp"
 #include "parser.hpp"
 #include "program.hpp"
+#include "vm.hpp"
 #include "Utils/error.hpp"
 #include "Utils/tokenScanner.hpp"
 #include "Utils/strlib.hpp"
@@ -17,17 +33,108 @@
 
 /* Function prototypes */
 
-void processLine(std::string line, Program &program, EvalState &state);
+EvalStatus processLine(std::string_view line, Program &program, EvalState &state);
 
-bool IsLegalWord(std::string a);
+bool loadProgramFile(const char *path, Program &program, EvalState &state);
 
-bool IsLegalInteger(std::string a);
+void compileProgram(Program &program, const std::string &path);
+
+void writeProfile(const Program &program);
+
+EvalStatus runProgram(Program &program, EvalState &state);
+
+void setLimit(Program &program, TokenScanner &scanner);
+
+bool parseLimit(const char *text, long &value);
+
+void printAllocationStats();
+
+bool IsLegalWord(std::string_view a);
+
+static std::string profile_path;   //--profile 指定的文件，每次 RUN 后写入
 
 /* Main program */
 
-int main() {
+int main(int argc, char **argv) {
+    output();   //装上输出缓冲区，之后 std::cout 的输出也先进缓冲区
     EvalState state;
     Program program;
+    const char *load_path = nullptr;
+    const char *emit_path = nullptr;
+    const char *data_path = nullptr;
+    const char *batch_path = nullptr;
+    int threads = 0;
+    bool run_loaded = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--tree") program.setBytecodeEnabled(false);  //用树解释器执行RUN，便于对比输出
+        else if (arg == "--load" && i + 1 < argc) load_path = argv[++i];  //批量载入程序文件
+        else if (arg == "--run") run_loaded = true;
+        else if (arg == "--emit-c" && i + 1 < argc) emit_path = argv[++i];  //把载入的程序翻译成 C++ 源文件后退出
+        else if (arg == "--max-steps" || arg == "--max-time") {  //限制 RUN 执行的语句数 / 运行时间（毫秒）
+            long limit;
+            if (i + 1 == argc || !parseLimit(argv[++i], limit)) {   //写错的限制不能悄悄变成不限制
+                std::cerr << arg << " needs a whole number, 0 or more, of "
+                          << (arg == "--max-steps" ? "statements" : "milliseconds") << std::endl;
+                return 1;
+            }
+            if (arg == "--max-steps") program.setLimits(limit, program.getTimeLimit());
+            else program.setLimits(program.getStepLimit(), limit);
+        }
+        else if (arg == "--profile" && i + 1 < argc) {  //开启逐行计时，每次 RUN 后把报告写进文件
+            profile_path = argv[++i];
+            program.setProfiling(true);
+        }
+        else if (arg == "--data" && i + 1 < argc) data_path = argv[++i];  //INPUT 从数据文件取值
+        else if (arg == "--batch" && i + 1 < argc) batch_path = argv[++i];  //对文件中的每组输入各运行一次程序后退出
+        else if (arg == "--threads" && i + 1 < argc) threads = std::atoi(argv[++i]);  //--batch 的线程数，0 为全部硬件线程
+        else if (arg == "--no-prompt") InputStatement::setPrompting(false);  //INPUT 不打印 " ? "
+        else if (arg == "--no-fold") setConstantFolding(false);  //关闭常量折叠，便于和未优化的结果对比
+        else if (arg == "--switch") VirtualMachine::setThreaded(false);  //VM 改用 switch 分派
+        else if (arg == "--no-jit") program.setJitEnabled(false);  //不生成机器码，总是用 VM
+        else if (arg == "--alloc-stats") std::atexit(printAllocationStats);  //退出时打印结点分配次数
+    }
+    InputData input_data;
+    if (data_path != nullptr) {
+        try {
+            input_data.load(data_path);
+        } catch (ErrorException &ex) {
+            std::cerr << ex.getMessage() << std::endl;
+            return 1;
+        }
+        state.setInputData(&input_data);
+    }
+    if (load_path != nullptr) {
+        if (!loadProgramFile(load_path, program, state)) {
+            std::cerr << "Cannot load " << load_path << std::endl;
+            return 1;
+        }
+        if (run_loaded) {
+            EvalStatus status = runProgram(program, state);
+            if (status != EVAL_OK) std::cout << statusMessage(status) << std::endl;
+            std::cout.flush();
+        }
+    }
+    if (batch_path != nullptr) {
+        std::vector<InputData> sets;
+        try {
+            sets = InputData::loadSets(batch_path);
+        } catch (ErrorException &ex) {
+            std::cerr << ex.getMessage() << std::endl;
+            return 1;
+        }
+        int failures = runBatch(program, state, sets, threads);
+        return failures == 0 ? 0 : 1;   //有任何一组出错就以 1 退出
+    }
+    if (emit_path != nullptr) {
+        try {
+            compileProgram(program, emit_path);
+        } catch (ErrorException &ex) {
+            std::cerr << ex.getMessage() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
     //cout << "Stub implementation of BASIC" << endl;
     while (true) {
         try {
@@ -35,7 +142,8 @@ int main() {
             getline(std::cin, input);
             if (input.empty())
                 return 0;
-            processLine(input, program, state);
+            EvalStatus status = processLine(input, program, state);
+            if (status != EVAL_OK) std::cout << statusMessage(status) << std::endl;  //运行时错误在这里统一转成报错信息
         } catch (ErrorException &ex) {
             std::cout << ex.getMessage() << std::endl;
         }
@@ -53,151 +161,318 @@ int main() {
  * need to replace this method with one that can respond correctly
  * when the user enters a program line (which begins with a number)
  * or one of the BASIC commands, such as LIST or RUN.
+ *
+ * Syntax errors are thrown with error(); run-time errors of immediate
+ * statements and of RUN are returned as a status for main to report.
  */
 
-void processLine(std::string line, Program &program, EvalState &state) {
+EvalStatus processLine(std::string_view line, Program &program, EvalState &state) {
     TokenScanner scanner;
     scanner.ignoreWhitespace();
     scanner.scanNumbers();
-    scanner.setInput(line);
+    scanner.setInputView(line);   //token 直接指向 line，不再拷贝
     int line_num = 0;
-    std::string str_first = scanner.nextToken(),str_command;
-    if (scanner.getTokenType(str_first) == NUMBER) {//如果有行号
-        line_num = stringToInteger(str_first);
+    Token first = scanner.nextTokenView();
+    std::string_view str_command;
+    if (first.type == NUMBER) {//如果有行号
+        line_num = stringToInteger(first.text);
         if (!scanner.hasMoreTokens()) {
             program.removeSourceLine(line_num);
-            return;
+            return EVAL_OK;
         }else{
-            str_command=scanner.nextToken();
+            str_command=scanner.nextTokenView().text;
         }
     }else{
-        str_command=str_first;
+        str_command=first.text;
     }
 
-    Statement *stmt;
-    if (str_command == "REM") { //REMARK
-        if (line_num == 0) return;
+    LineArena line_arena;
+    if (line_num != 0) line_arena = LineArena(program.getArena());   //程序行的结点都放进这一行自己的 arena
+    ArenaScope scope(line_arena);
+
+    Keyword command = classifyKeyword(str_command);   //关键字按长度和首字母一次分类，不再逐个比较字符串
+    Statement *stmt = nullptr;
+    if (command == KW_REM) { //REMARK
+        if (line_num == 0) return EVAL_OK;
         stmt = new RemStatement();
-    } else if (str_command == "LET") {  //LET
-        std::string var;
-        var = scanner.nextToken();  //获取变量名
-        if (scanner.getTokenType(var) != WORD || !IsLegalWord(var)) {
+    } else if (command == KW_LET) {  //LET
+        Token var_token = scanner.nextTokenView();  //获取变量名
+        if (var_token.type != WORD || !IsLegalWord(var_token.text)) {
             error("SYNTAX ERROR"); //会自动构建一个异常类型并且抛出
         }
-        std::string op;
-        op = scanner.nextToken();
-        if (op != "=") {
+        std::string var(var_token.text);
+        if (scanner.nextTokenView().text != "=") {
             error("SYNTAX ERROR"); //会自动构建一个异常类型并且抛出
         }
         Expression *exp;
         exp = parseExp(scanner);
         if (line_num == 0) {
-            int value;
-            value = exp->eval(state); //get右值；
+            exp->resolve(state);
+            EvalStatus status = EVAL_OK;
+            int value = exp->eval_not_delete(state, status); //get右值；
             delete exp;
+            if (status != EVAL_OK) return status;
             state.setValue(var, value); //立刻执行
         } else {
             stmt = new LetStatement(exp, var);
         }
-    } else if (str_command == "PRINT") {  //PRINT
+    } else if (command == KW_PRINT) {  //PRINT
         Expression *exp_print = parseExp(scanner);
         if (line_num == 0) {
-            int value_print = exp_print->eval(state);
+            exp_print->resolve(state);
+            EvalStatus status = EVAL_OK;
+            int value_print = exp_print->eval_not_delete(state, status);
             delete exp_print;
-            std::cout << value_print<<'\n';
+            if (status != EVAL_OK) return status;
+            output().printInteger(value_print);
         } else {
             stmt = new PrintStatement(exp_print);
         }
-    } else if (str_command == "INPUT") {
-        std::string var = scanner.nextToken();
-        if(scanner.getTokenType(var)!=WORD || !IsLegalWord(var)) error("SYNTAX ERROR");
+    } else if (command == KW_INPUT) {
+        Token var = scanner.nextTokenView();
+        if(var.type!=WORD || !IsLegalWord(var.text)) error("SYNTAX ERROR");
         if(line_num==0){  //立刻执行
-            std::cout<<" ? ";
-            std::string value;
-            getline(std::cin, value);
-            while(!IsLegalInteger(value)){
-                std::cout<<"INVALID NUMBER\n";
-                std::cout<<" ? ";
-                getline(std::cin, value);
-            }
-            int value_int= stringToInteger(value);
-            state.setValue(var,value_int);
+            int value_int;
+            EvalStatus status = InputStatement::readValue(state, value_int);
+            if (status != EVAL_OK) return status;
+            state.setValue(std::string(var.text),value_int);
         }else{
-            stmt = new InputStatement(var);
+            stmt = new InputStatement(std::string(var.text));
         }
-    } else if (str_command == "END") {
+    } else if (command == KW_END) {
         if (line_num == 0) {
             exit(0);
         } else {
             stmt = new EndStatement();
         }
-    } else if (str_command == "GOTO") {
-        int num = stringToInteger(scanner.nextToken());
+    } else if (command == KW_GOTO) {
+        int num = stringToInteger(scanner.nextTokenView().text);
         stmt = new GotoStatement(num);
-    } else if (str_command == "RUN") {
-        program.execute_all(state);
-    } else if (str_command == "LIST") {
+    } else if (command == KW_RUN) {
+        return runProgram(program, state);
+    } else if (command == KW_LIST) {
         program.list();
-    } else if (str_command == "CLEAR") {
+    } else if (command == KW_CLEAR) {
         program.clear();
         state.Clear();
-    } else if (str_command == "QUIT") {
+    } else if (command == KW_QUIT) {
         exit(0);
-    } else if (str_command == "IF") {
+    } else if (command == KW_PROFILE) {
+        if (line_num != 0) error("SYNTAX ERROR");
+        std::string_view option = scanner.nextTokenView().text;
+        if (option == "ON") program.setProfiling(true);
+        else if (option == "OFF") program.setProfiling(false);
+        else if (option.empty()) program.printProfile(std::cout);
+        else error("SYNTAX ERROR");
+    } else if (command == KW_LIMIT) {
+        if (line_num != 0) error("SYNTAX ERROR");
+        setLimit(program, scanner);
+    } else if (command == KW_COMPILE) {
+        if (line_num != 0) error("SYNTAX ERROR");
+        size_t rest = str_command.data() + str_command.size() - line.data();   //命令后面的整段文字是文件名
+        compileProgram(program, trim(std::string(line.substr(rest))));
+    } else if (command == KW_IF) {
         if (line_num == 0) error("SYNTAX ERROR");
-        std::string lhs, op, rhs, temp;
+        std::string lhs, rhs;
+        std::string_view op, temp;
         int num;
-        temp = scanner.nextToken();
+        temp = scanner.nextTokenView().text;
         while (temp!="=" && temp!=">" && temp!="<") {
             lhs += temp;
-            temp = scanner.nextToken();
+            temp = scanner.nextTokenView().text;
         }
         op = temp;
-        temp = scanner.nextToken();
+        temp = scanner.nextTokenView().text;
         while (temp != "THEN") {
             rhs += temp;
-            temp = scanner.nextToken();
+            temp = scanner.nextTokenView().text;
         }
-        temp = scanner.nextToken();
+        temp = scanner.nextTokenView().text;
         num = stringToInteger(temp);
         TokenScanner lhss, rhss;
         lhss.ignoreWhitespace();
         rhss.ignoreWhitespace();
         lhss.scanNumbers();
         rhss.scanNumbers();
-        lhss.setInput(lhs);
-        rhss.setInput(rhs);
+        lhss.setInputView(lhs);
+        rhss.setInputView(rhs);
         Expression *lhs_exp,*rhs_exp;
         lhs_exp=parseExp(lhss);
         rhs_exp= parseExp(rhss);
-        stmt = new IfStatement(lhs_exp, op, rhs_exp, num);
+        stmt = new IfStatement(makeComparisonExp(op, lhs_exp, rhs_exp), num);
     }
 
     if (line_num != 0) {
-        program.addSourceLine(line_num, line);
-        program.setParsedStatement(line_num, stmt);
+        if (stmt != nullptr) stmt->resolve(state);
+        program.addParsedLine(line_num, line, stmt, std::move(line_arena));
     }
+    return EVAL_OK;
 }
 
-bool IsLegalWord(std::string a){
-    if(a=="REM") return false;
-    if(a=="LET") return false;
-    if(a=="PRINT") return false;
-    if(a=="END") return false;
-    if(a=="GOTO") return false;
-    if(a=="IF") return false;
-    if(a=="THEN") return false;
-    if(a=="RUN") return false;
-    if(a=="LIST") return false;
-    if(a=="CLEAR") return false;
-    if(a=="QUIT") return false;
-    if(a=="HELP") return false;
-    return true;
+/*
+ * Function: compileProgram
+ * Usage: compileProgram(program, path);
+ * -------------------------------------
+ * Writes the C++ translation of the program to path, or to standard
+ * output if path is empty.  This is the COMPILE command and the
+ * --emit-c option.
+ */
+
+void compileProgram(Program &program, const std::string &path) {
+    if (path.empty()) {
+        SourceEmitter().emit(program, std::cout);
+        return;
+    }
+    std::ofstream out(path);
+    if (!out) error("CANNOT OPEN FILE");
+    SourceEmitter().emit(program, out);
 }
 
-bool IsLegalInteger(std::string a){
-    for(int i=0;i<a.length();i++){
-        if(!('0'<=a[i] && a[i]<='9'|| a[i]=='-')) return false;
+/*
+ * Function: runProgram
+ * Usage: EvalStatus status = runProgram(program, state);
+ * ------------------------------------------------------
+ * The RUN command.  After the run the profile is written if --profile
+ * asked for it, and a run stopped by a limit reports its progress
+ * counters on standard error.
+ */
+
+EvalStatus runProgram(Program &program, EvalState &state) {
+    EvalStatus status = program.execute_all(state);
+    writeProfile(program);
+    if (status == EVAL_STEP_LIMIT || status == EVAL_TIME_LIMIT) {
+        const RunStats &stats = program.lastRun();
+        std::cerr << "RUN stopped before line " << stats.lineNumber << " after " << stats.steps
+                  << " statements, " << stats.milliseconds << " ms" << std::endl;
     }
+    return status;
+}
+
+/*
+ * Function: setLimit
+ * Usage: setLimit(program, scanner);
+ * ----------------------------------
+ * The LIMIT command.  LIMIT STEPS n and LIMIT TIME ms set one limit,
+ * where 0 removes it; LIMIT OFF removes both; LIMIT alone prints them.
+ */
+
+void setLimit(Program &program, TokenScanner &scanner) {
+    std::string_view option = scanner.nextTokenView().text;
+    if (option.empty()) {
+        long steps = program.getStepLimit(), time = program.getTimeLimit();
+        std::cout << "STEPS " << (steps == 0 ? "OFF" : std::to_string(steps)) << '\n'
+                  << "TIME " << (time == 0 ? "OFF" : std::to_string(time) + " MS") << '\n';
+        return;
+    }
+    if (option == "OFF") {
+        program.setLimits(0, 0);
+        return;
+    }
+    Token value = scanner.nextTokenView();
+    if (value.type != NUMBER || scanner.hasMoreTokens()) error("SYNTAX ERROR");
+    long limit = stringToInteger(value.text);
+    if (option == "STEPS") program.setLimits(limit, program.getTimeLimit());
+    else if (option == "TIME") program.setLimits(program.getStepLimit(), limit);
+    else error("SYNTAX ERROR");
+}
+
+/*
+ * Function: writeProfile
+ * Usage: writeProfile(program);
+ * -----------------------------
+ * Writes the profile of the last RUN to the file named by --profile,
+ * replacing the previous report.  Does nothing without --profile.
+ */
+
+void writeProfile(const Program &program) {
+    if (profile_path.empty()) return;
+    std::ofstream out(profile_path);
+    if (!out) {
+        std::cerr << "Cannot write " << profile_path << std::endl;
+        return;
+    }
+    program.printProfile(out);
+}
+
+/*
+ * Function: parseLimit
+ * Usage: if (parseLimit(text, value)) ...
+ * ---------------------------------------
+ * Parses the value of --max-steps or --max-time.  Returns false unless
+ * the whole text is a number that fits in a long and is not negative.
+ */
+
+bool parseLimit(const char *text, long &value) {
+    const char *end = text + std::strlen(text);
+    auto result = std::from_chars(text, end, value);
+    return result.ec == std::errc() && result.ptr == end && end != text && value >= 0;
+}
+
+/*
+ * Function: loadProgramFile
+ * Usage: if (loadProgramFile(path, program, state)) ...
+ * -----------------------------------------------------
+ * Maps the file into memory and hands each line to processLine as a
+ * view into the mapping, so the text is only copied once, into the
+ * program.  Empty lines are skipped; unnumbered lines are executed as
+ * commands, exactly as if they had been typed.  Returns false if the
+ * file cannot be opened or mapped.
+ */
+
+bool loadProgramFile(const char *path, Program &program, EvalState &state) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) < 0) {
+        close(fd);
+        return false;
+    }
+    size_t size = info.st_size;
+    void *data = nullptr;
+    if (size > 0) {
+        data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        madvise(data, size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+    std::string_view text((const char *) data, size);
+    while (!text.empty()) {
+        size_t end = text.find('\n');
+        std::string_view line = text.substr(0, end);
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (line.empty()) continue;
+        try {
+            EvalStatus status = processLine(line, program, state);
+            if (status != EVAL_OK) std::cout << statusMessage(status) << std::endl;
+        } catch (ErrorException &ex) {
+            std::cout << ex.getMessage() << std::endl;
+        }
+    }
+    if (data != nullptr) munmap(data, size);
     return true;
+}
+
+/*
+ * Function: printAllocationStats
+ * Usage: std::atexit(printAllocationStats);
+ * -----------------------------------------
+ * Reports on std::cerr how Statement and Expression nodes were
+ * allocated, for the --alloc-stats option.
+ */
+
+void printAllocationStats() {
+    const AllocationStats &stats = allocationStats();
+    std::cerr << "nodes in arenas: " << stats.arenaAllocations
+              << ", heap node allocations: " << stats.heapAllocations
+              << ", heap node frees: " << stats.heapFrees
+              << ", slab allocations: " << stats.slabAllocations
+              << ", slab frees: " << stats.slabFrees << std::endl;
+}
+
+bool IsLegalWord(std::string_view a){
+    return !isReservedWord(classifyKeyword(a));
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
  */
 
 #include <cctype>
+#include <charconv>
 #include <iomanip>
 #include <iostream>
 #include "error.hpp"
@@ -15,23 +16,34 @@
 /*
  * Implementation notes: numeric conversion
  * ----------------------------------------
- * These functions use the <sstream> library to perform the conversion.
+ * The real-number functions use the <sstream> library to perform the
+ * conversion.  The integer functions are called for every number token
+ * and every INPUT value, so they use <charconv> instead and accept
+ * exactly what the stream version accepted: leading and trailing
+ * whitespace, an optional + or - sign directly before the digits, and
+ * only values that fit in an int.  from_chars itself takes neither the
+ * whitespace nor the + sign, so those are skipped here.
  */
 
-std::string integerToString(int n) {
-    std::ostringstream stream;
-    stream << n;
-    return stream.str();
+static bool isStreamSpace(char ch) {
+    return ch == ' ' || ('\t' <= ch && ch <= '\r');   //与 std::ws 在 "C" locale 下跳过的字符相同
 }
 
-int stringToInteger(std::string str) {
+std::string integerToString(int n) {
+    char buffer[16];
+    char *end = std::to_chars(buffer, buffer + sizeof buffer, n).ptr;
+    return std::string(buffer, end);
+}
 
-    std::istringstream stream(str);
-    int value;
-    stream >> value;
-    if (!stream.eof()) stream >> std::ws;
-    if (stream.fail() || !stream.eof()) {
-        error("stringToInteger: Illegal integer format (" + str + ")");
+int stringToInteger(std::string_view str) {
+    const char *start = str.data(), *finish = str.data() + str.size();
+    while (start < finish && isStreamSpace(*start)) start++;
+    if (start < finish && *start == '+' && finish - start > 1 && start[1] != '-') start++;
+    int value = 0;
+    auto [end, ec] = std::from_chars(start, finish, value);
+    while (ec == std::errc() && end < finish && isStreamSpace(*end)) end++;
+    if (ec != std::errc() || end != finish) {
+        error("stringToInteger: Illegal integer format (" + std::string(str) + ")");
     }
     return value;
 }
@@ -10,6 +10,7 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 
 /*
  * Function: integerToString
@@ -29,10 +30,11 @@ std::string integerToString(int n);
  * Converts a string of digits into an integer.  If the string is not a
  * legal integer or contains extraneous characters other than whitespace,
  * <code>stringToInteger</code> calls <code>error</code> with an
- * appropriate message.
+ * appropriate message.  The string may be a view into a larger buffer,
+ * such as a token, and is not copied unless the conversion fails.
  */
 
-int stringToInteger(std::string str);
+int stringToInteger(std::string_view str);
 
 /*
  * Function: realToString
@@ -26,41 +26,38 @@ TokenScanner::TokenScanner(std::istream &infile) {
 }
 
 TokenScanner::~TokenScanner() {
-    delete isp;
-    delete savedTokens;
 }
 
 void TokenScanner::setInput(std::string str) {
-    stringInputFlag = true;
     buffer = str;   //buffer: The original argument string
-    if (isp != nullptr) delete isp;                            //？？？？？？？？？如果这个isp不是new出来的，而是对流对象取地址运算得到的，也能delete吗？
-    isp = new std::istringstream(buffer);
-    delete savedTokens;
-    savedTokens = nullptr;
+    setInputView(buffer);
+}
+
+void TokenScanner::setInputView(std::string_view text) {
+    stringInputFlag = true;
+    input = text;   //字符串输入不再经过 istringstream，直接用下标扫描
+    cursor = 0;
+    isp = nullptr;
+    savedCount = 0;
+    savedOverflow.clear();
 }
 
 void TokenScanner::setInput(std::istream &infile) {
     stringInputFlag = false;
-    if (isp != nullptr)delete isp;
-    isp = &infile;
-    delete savedTokens;
-    savedTokens = nullptr;
+    isp = &infile;   //流不归 scanner 所有，不能 delete
+    savedCount = 0;
+    savedOverflow.clear();
 }
 
 bool TokenScanner::hasMoreTokens() {
-    std::string token = nextToken();
+    Token token = nextTokenView();
     saveToken(token);
-    return (token != "");
+    return !token.text.empty();
 }
 
 std::string TokenScanner::nextToken() {
-    if (savedTokens != nullptr) {  //从链表savedtokens 里面读取头结点的字符串，并且把头结点从链表savedtoken里删除
-        StringCell *cp = savedTokens;
-        std::string token = cp->str;
-        savedTokens = cp->link;
-        delete cp;
-        return token;
-    }
+    if (savedCount > 0) return popSavedToken();  //先取回 saveToken 压入的 token
+    if (stringInputFlag) return std::string(scanTokenView().text);
     while (true) {
         if (ignoreWhitespaceFlag) skipSpaces();
         int ch = isp->get();
@@ -111,11 +108,30 @@ std::string TokenScanner::nextToken() {
     }
 }
 
-void TokenScanner::saveToken(std::string token) {  //将字符串token插入链表savedtoken的头结点
-    StringCell *cp = new StringCell;
-    cp->str = token;
-    cp->link = savedTokens;
-    savedTokens = cp;
+Token TokenScanner::nextTokenView() {
+    if (savedCount > 0 || !stringInputFlag) {   //这两种情况没有可以指向的输入，借 savedText 存放
+        savedText = nextToken();
+        return {savedText, getTokenType(savedText)};
+    }
+    return scanTokenView();
+}
+
+void TokenScanner::saveToken(std::string token) {  //压入 saved token 栈，前几个放在对象内部
+    if (savedCount < SAVED_INLINE) {
+        savedInline[savedCount] = std::move(token);
+    } else {
+        savedOverflow.push_back(std::move(token));
+    }
+    savedCount++;
+}
+
+void TokenScanner::saveToken(Token token) {
+    const char *text = token.text.data();
+    if (stringInputFlag && text >= input.data() && text <= input.data() + input.size()) {
+        cursor = text - input.data();   //指向输入的 token 只需把游标退回到它的开头
+    } else {
+        saveToken(std::string(token.text));
+    }
 }
 
 void TokenScanner::ignoreWhitespace() {
@@ -138,18 +154,31 @@ void TokenScanner::addWordCharacters(std::string str) {
     wordChars += str;
 }
 
-void TokenScanner::addOperator(std::string op) {  //将op插入链表operators的头部
-    StringCell *cp = new StringCell;
-    cp->str = op;
-    cp->link = operators;
-    operators = cp;
+void TokenScanner::addOperator(std::string op) {  //把 op 插入运算符 trie
+    if (op.empty()) return;
+    int parent = NO_NODE;
+    for (size_t i = 0; i < op.length(); i++) {
+        unsigned char ch = op[i];
+        int first = parent == NO_NODE ? operatorRoot[ch] : operatorNodes[parent].child;
+        int node = first;
+        while (node != NO_NODE && operatorNodes[node].ch != ch) node = operatorNodes[node].sibling;
+        if (node == NO_NODE) {
+            node = int(operatorNodes.size());
+            operatorNodes.push_back({ch, false, NO_NODE, first});   //新结点插到兄弟链表头部
+            if (parent == NO_NODE) operatorRoot[ch] = node;
+            else operatorNodes[parent].child = node;
+        }
+        if (i + 1 == op.length()) operatorNodes[node].terminal = true;
+        parent = node;
+    }
 }
 
 int TokenScanner::getPosition() const {
-    if (savedTokens == nullptr) {
-        return int(isp->tellg());
+    int pos = stringInputFlag ? int(cursor) : int(isp->tellg());
+    if (savedCount == 0) {
+        return pos;
     } else {
-        return int(isp->tellg()) - savedTokens->str.length();    //?????????????????????????如果savedtoken链表里有很多节点呢？以及对于空格的处理？
+        return pos - topSavedToken().length();    //?????????????????????????如果savedtoken链表里有很多节点呢？以及对于空格的处理？
     }
     return -1;     //？？？？？？？？？？？？？？？？？？？？？？？？？？？？调用多次就返回-1是什么意思以及是如何做到的？
 }
@@ -167,8 +196,8 @@ void TokenScanner::verifyToken(std::string expected) {
     }
 };
 
-TokenType TokenScanner::getTokenType(std::string token) const {
-    if (token == "") return TokenType(EOF);
+TokenType TokenScanner::getTokenType(std::string_view token) const {
+    if (token.empty()) return TokenType(EOF);
     char ch = token[0];
     if (isspace(ch)) return SEPARATOR;       //?????????????separator是什么，它的第一个字符为什么是空格？
     if (ch == '"' || (ch == '\'' && token.length() > 1)) return STRING;
@@ -253,10 +282,15 @@ std::string TokenScanner::getStringValue(std::string token) const {
 }
 
 int TokenScanner::getChar() {
+    if (stringInputFlag) return cursor < input.size() ? (unsigned char) input[cursor++] : EOF;
     return isp->get();
 }
 
 void TokenScanner::ungetChar(int ch) {
+    if (stringInputFlag) {
+        if (ch != EOF && cursor > 0) cursor--;
+        return;
+    }
     isp->unget();
 }
 
@@ -267,7 +301,29 @@ void TokenScanner::initScanner() {
     ignoreCommentsFlag = false;
     scanNumbersFlag = false;
     scanStringsFlag = false;
-    operators = nullptr;
+    for (int &root: operatorRoot) root = NO_NODE;
+}
+
+/*
+ * Implementation notes: popSavedToken, topSavedToken
+ * --------------------------------------------------
+ * The saved token stack fills savedInline first and continues in
+ * savedOverflow, so the top is in the vector whenever it is non-empty.
+ */
+
+std::string TokenScanner::popSavedToken() {
+    savedCount--;
+    if (savedCount >= SAVED_INLINE) {
+        std::string token = std::move(savedOverflow.back());
+        savedOverflow.pop_back();
+        return token;
+    }
+    return std::move(savedInline[savedCount]);
+}
+
+const std::string &TokenScanner::topSavedToken() const {
+    if (savedCount > SAVED_INLINE) return savedOverflow.back();
+    return savedInline[savedCount - 1];
 }
 
 /*
@@ -413,26 +469,203 @@ std::string TokenScanner::scanString() {
     return token + delim;
 }
 
+/*
+ * Implementation notes: scanTokenView
+ * -----------------------------------
+ * The string-input counterpart of nextToken.  It walks the input with
+ * an index instead of get/unget on a stream and returns a view of the
+ * token's characters.  The tokens are the same ones nextToken reads
+ * from a stream, including its behaviour at the end of the input, where
+ * a failed get leaves all later ungets without effect.
+ */
+
+Token TokenScanner::scanTokenView() {
+    const size_t n = input.size();
+    while (true) {
+        if (ignoreWhitespaceFlag) {
+            while (cursor < n && isspace((unsigned char) input[cursor])) cursor++;
+        }
+        if (cursor >= n) return {input.substr(n), TokenType(EOF)};
+        size_t start = cursor;
+        int ch = (unsigned char) input[cursor++];
+        if (ch == '/' && ignoreCommentsFlag && cursor < n) {
+            if (input[cursor] == '/') {
+                while (cursor < n) {
+                    char c = input[cursor++];
+                    if (c == '\n' || c == '\r') break;
+                }
+                continue;
+            } else if (input[cursor] == '*') {
+                int prev = EOF;
+                cursor++;
+                while (cursor < n) {
+                    int c = (unsigned char) input[cursor++];
+                    if (prev == '*' && c == '/') break;
+                    prev = c;
+                }
+                continue;
+            }
+        }
+        if ((ch == '"' || ch == '\'') && scanStringsFlag) {
+            cursor = start;
+            return scanStringView();
+        }
+        if (isdigit(ch) && scanNumbersFlag) {
+            cursor = start;
+            return scanNumberView();
+        }
+        if (isWordCharacter(ch)) {
+            while (cursor < n && isWordCharacter(input[cursor])) cursor++;
+            std::string_view token = input.substr(start, cursor - start);
+            return {token, getTokenType(token)};
+        }
+        size_t length = 1;   //最长的运算符匹配，没有匹配时只取一个字符
+        size_t scanned = 1;
+        int node = operatorRoot[ch];
+        while (node != NO_NODE) {
+            if (operatorNodes[node].terminal) length = scanned;
+            if (start + scanned >= n) break;
+            node = findChild(node, input[start + scanned]);
+            scanned++;
+        }
+        cursor = node != NO_NODE ? n : start + length;   //读到末尾时流版本的 unget 不起作用
+        std::string_view token = input.substr(start, length);
+        return {token, getTokenType(token)};
+    }
+}
+
+/*
+ * Implementation notes: scanNumberView
+ * ------------------------------------
+ * The same finite-state machine as scanNumber.  As with the stream
+ * version, a trailing exponent marker without digits stays part of the
+ * token even though the cursor is moved back before it.
+ */
+
+Token TokenScanner::scanNumberView() {
+    const size_t n = input.size();
+    size_t start = cursor;
+    size_t length = 0;
+    bool atEof = false;
+    NumberScannerState state = INITIAL_STATE;
+    while (state != FINAL_STATE) {
+        int ch = EOF;
+        if (cursor < n) ch = (unsigned char) input[cursor++];
+        else atEof = true;
+        int back = 0;   //需要退回的字符数
+        switch (state) {
+            case INITIAL_STATE:
+                if (!isdigit(ch)) {
+                    error("Internal error: illegal call to scanNumber");
+                }
+                state = BEFORE_DECIMAL_POINT;
+                break;
+            case BEFORE_DECIMAL_POINT:
+                if (ch == '.') {
+                    state = AFTER_DECIMAL_POINT;
+                } else if (ch == 'E' || ch == 'e') {
+                    state = STARTING_EXPONENT;
+                } else if (!isdigit(ch)) {
+                    back = 1;
+                    state = FINAL_STATE;
+                }
+                break;
+            case AFTER_DECIMAL_POINT:
+                if (ch == 'E' || ch == 'e') {
+                    state = STARTING_EXPONENT;
+                } else if (!isdigit(ch)) {
+                    back = 1;
+                    state = FINAL_STATE;
+                }
+                break;
+            case STARTING_EXPONENT:
+                if (ch == '+' || ch == '-') {
+                    state = FOUND_EXPONENT_SIGN;
+                } else if (isdigit(ch)) {
+                    state = SCANNING_EXPONENT;
+                } else {
+                    back = 2;
+                    state = FINAL_STATE;
+                }
+                break;
+            case FOUND_EXPONENT_SIGN:
+                if (isdigit(ch)) {
+                    state = SCANNING_EXPONENT;
+                } else {
+                    back = 3;
+                    state = FINAL_STATE;
+                }
+                break;
+            case SCANNING_EXPONENT:
+                if (!isdigit(ch)) {
+                    back = 1;
+                    state = FINAL_STATE;
+                }
+                break;
+            default:
+                state = FINAL_STATE;
+                break;
+        }
+        if (state != FINAL_STATE) {
+            length++;
+        } else if (!atEof) {
+            cursor -= back;
+        }
+    }
+    std::string_view token = input.substr(start, length);
+    return {token, getTokenType(token)};
+}
+
+/*
+ * Implementation notes: scanStringView
+ * ------------------------------------
+ * The token is the quoted string exactly as it appears in the input,
+ * so it can be returned as a view of the input.
+ */
+
+Token TokenScanner::scanStringView() {
+    const size_t n = input.size();
+    size_t start = cursor;
+    char delim = input[cursor++];
+    bool escape = false;
+    while (true) {
+        if (cursor >= n) error("TokenScanner found unterminated string");
+        char ch = input[cursor++];
+        if (ch == delim && !escape) break;
+        escape = (ch == '\\') && !escape;
+    }
+    std::string_view token = input.substr(start, cursor - start);
+    return {token, getTokenType(token)};
+}
+
 /*
  * Implementation notes: isOperator, isOperatorPrefix
  * --------------------------------------------------
- * These methods search the list of operators and return true if the
- * specified operator is either in the list or a prefix of an operator
- * in the list, respectively.  This code could be made considerably more
- * efficient by implementing operators as a trie.
+ * These methods look the operator up in the trie and return true if
+ * the specified operator is either in the set or a prefix of an
+ * operator in the set, respectively.
  */
 
-bool TokenScanner::isOperator(std::string op) {     //判断所给运算符是否在链表operator里出现
-    for (StringCell *cp = operators; cp != nullptr; cp = cp->link) {
-        if (op == cp->str) return true;
-    }
-    return false;
+bool TokenScanner::isOperator(std::string_view op) const {
+    int node = findOperatorNode(op);
+    return node != NO_NODE && operatorNodes[node].terminal;
 }
 
-bool TokenScanner::isOperatorPrefix(std::string op) {
-    for (StringCell *cp = operators; cp != nullptr; cp = cp->link) {
-        if (startsWith(cp->str, op)) return true;
+bool TokenScanner::isOperatorPrefix(std::string_view op) const {
+    return findOperatorNode(op) != NO_NODE;
+}
+
+int TokenScanner::findOperatorNode(std::string_view op) const {
+    if (op.empty()) return NO_NODE;
+    int node = operatorRoot[(unsigned char) op[0]];
+    for (size_t i = 1; i < op.length() && node != NO_NODE; i++) {
+        node = findChild(node, op[i]);
     }
-    return false;
+    return node;
 }
 
+int TokenScanner::findChild(int node, unsigned char ch) const {
+    int child = operatorNodes[node].child;
+    while (child != NO_NODE && operatorNodes[child].ch != ch) child = operatorNodes[child].sibling;
+    return child;
+}
@@ -16,6 +16,8 @@
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <string_view>
+#include <vector>
 
 /*
  * Type: TokenType
@@ -28,6 +30,19 @@ enum TokenType {
     SEPARATOR, WORD, NUMBER, STRING, OPERATOR
 };
 
+/*
+ * Type: Token
+ * -----------
+ * A token returned by <code>nextTokenView</code>.  The text is a view
+ * into the scanner input and stays valid as long as that input does;
+ * the type is the value <code>getTokenType</code> would return.
+ */
+
+struct Token {
+    std::string_view text;
+    TokenType type = TokenType(EOF);
+};
+
 /*
  * Class: TokenScanner
  * -------------------
@@ -84,13 +99,25 @@ public:
  *        scanner.setInput(infile);
  * --------------------------------
  * Sets the token stream for this scanner to the specified string or
- * input stream.  Any previous token stream is discarded.
+ * input stream.  Any previous token stream is discarded.  String input
+ * is copied once and then scanned in place with an index cursor.
  */
 
     void setInput(std::string str);
 
     void setInput(std::istream &infile);
 
+/*
+ * Method: setInputView
+ * Usage: scanner.setInputView(text);
+ * ----------------------------------
+ * Like <code>setInput(str)</code>, but scans the characters in place
+ * without copying them.  The caller keeps the text alive for as long
+ * as the scanner or any token view obtained from it is used.
+ */
+
+    void setInputView(std::string_view text);
+
 /*
  * Method: hasMoreTokens
  * Usage: if (scanner.hasMoreTokens()) ...
@@ -111,6 +138,19 @@ public:
 
     std::string nextToken();
 
+/*
+ * Method: nextTokenView
+ * Usage: Token token = scanner.nextTokenView();
+ * ---------------------------------------------
+ * Returns the next token together with its type, without allocating.
+ * For string input the text points into the input; a token that was
+ * pushed back with <code>saveToken(std::string)</code>, or any token
+ * read from a stream, is only valid until the next call.  At the end
+ * of the input the text is empty and the type is <code>EOF</code>.
+ */
+
+    Token nextTokenView();
+
 /*
  * Method: saveToken
  * Usage: scanner.saveToken(token);
@@ -118,11 +158,15 @@ public:
  * Pushes the specified token back into this scanner's input stream.
  * On the next call to <code>nextToken</code>, the scanner will return
  * the saved token without reading any additional characters from the
- * token stream.
+ * token stream.  Saving a token view that points into string input
+ * just moves the cursor back to its start, so views must be saved
+ * in the reverse order in which they were read.
  */
 
     void saveToken(std::string token);
 
+    void saveToken(Token token);
+
 /*
  * Method: getPosition
  * Usage: int pos = scanner.getPosition();
@@ -264,7 +308,7 @@ public:
  * <code>STRING</code>, or <code>OPERATOR</code>.
  */
 
-    TokenType getTokenType(std::string token) const;
+    TokenType getTokenType(std::string_view token) const;
 
 /*
  * Method: getChar
@@ -306,20 +350,35 @@ public:
 private:
 
 /*
- * Private type: StringCell
- * ------------------------
- * This type is used to construct linked lists of cells, which are used
- * to represent both the stack of saved tokens and the set of defined
- * operators.  These types cannot use the Stack and Lexicon classes
- * directly because tokenscanner.h is an extremely low-level interface,
- * and doing so would create circular dependencies in the .h files.
+ * Private type: OperatorNode
+ * --------------------------
+ * The multicharacter operators are stored as a trie.  The first
+ * character is dispatched through a 256-entry table; below that every
+ * node keeps its children as a short sibling list, since operators
+ * rarely share more than a character or two.  Node indices are
+ * positions in the operatorNodes vector and NO_NODE marks a missing
+ * link.
  */
 
-    struct StringCell {
-        std::string str;
-        StringCell *link;
+    static const int NO_NODE = -1;
+
+    struct OperatorNode {
+        unsigned char ch;
+        bool terminal;
+        int child;
+        int sibling;
     };
 
+/*
+ * Private constant: SAVED_INLINE
+ * ------------------------------
+ * Saved tokens form a stack whose first SAVED_INLINE entries live inside
+ * the scanner.  Parsers rarely push back more than one token, so the
+ * overflow vector is almost never touched.
+ */
+
+    static const int SAVED_INLINE = 4;
+
     enum NumberScannerState {
         INITIAL_STATE,
         BEFORE_DECIMAL_POINT,
@@ -331,6 +390,9 @@ private:
     };
 
     std::string buffer;              /* The original argument string */
+    std::string_view input;          /* The characters of string input */
+    size_t cursor = 0;               /* Scan position within input   */
+    std::string savedText;           /* Backing text for some views  */
     std::istream *isp = nullptr;     /* The input stream for tokens  */
     bool stringInputFlag;            /* Flag indicating string input */
     bool ignoreWhitespaceFlag;       /* Scanner ignores whitespace   */
@@ -338,8 +400,11 @@ private:
     bool scanNumbersFlag;            /* Scanner parses numbers       */
     bool scanStringsFlag;            /* Scanner parses strings       */
     std::string wordChars;           /* Additional word characters   */
-    StringCell *savedTokens = nullptr;         /* Stack of saved tokens        */
-    StringCell *operators = nullptr;           /* List of multichar operators  */
+    std::string savedInline[SAVED_INLINE];     /* Bottom of saved token stack  */
+    std::vector<std::string> savedOverflow;    /* Rest of saved token stack    */
+    int savedCount = 0;                        /* Number of saved tokens       */
+    int operatorRoot[256];                     /* First-character dispatch     */
+    std::vector<OperatorNode> operatorNodes;   /* Trie of multichar operators  */
 
 /* Private method prototypes */
 
@@ -347,15 +412,29 @@ private:
 
     void skipSpaces();
 
+    std::string popSavedToken();
+
+    const std::string &topSavedToken() const;
+
+    int findOperatorNode(std::string_view op) const;
+
+    int findChild(int node, unsigned char ch) const;
+
     std::string scanWord();
 
     std::string scanNumber();
 
     std::string scanString();
 
-    bool isOperator(std::string op);
+    Token scanTokenView();
+
+    Token scanNumberView();
+
+    Token scanStringView();
+
+    bool isOperator(std::string_view op) const;
 
-    bool isOperatorPrefix(std::string op);
+    bool isOperatorPrefix(std::string_view op) const;
 
 };
 
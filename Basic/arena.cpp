@@ -0,0 +1,145 @@
+/*
+ * File: arena.cpp
+ * ---------------
+ * This file implements the allocators declared in arena.h.
+ */
+
+#include <new>
+#include "arena.hpp"
+
+static AllocationStats stats;
+
+static thread_local LineArena *currentArena = nullptr;
+
+AllocationStats &allocationStats() {
+    return stats;
+}
+
+/* Implementation of Arena */
+
+Arena::~Arena() {
+    release();
+}
+
+void *Arena::allocateChunk() {
+    if (freeList != nullptr) {
+        FreeChunk *chunk = freeList;
+        freeList = chunk->next;
+        return chunk;
+    }
+    if (slabUsed == SLAB_CHUNKS) {
+        slabs.push_back(static_cast<char *>(::operator new(CHUNK_SIZE * SLAB_CHUNKS)));
+        stats.slabAllocations++;
+        slabUsed = 0;
+    }
+    return slabs.back() + CHUNK_SIZE * slabUsed++;
+}
+
+void Arena::freeChunk(void *chunk) {
+    auto *cell = static_cast<FreeChunk *>(chunk);
+    cell->next = freeList;
+    freeList = cell;
+}
+
+void Arena::release() {
+    for (char *slab: slabs) ::operator delete(slab);
+    stats.slabFrees += long(slabs.size());
+    slabs.clear();
+    slabUsed = SLAB_CHUNKS;
+    freeList = nullptr;
+}
+
+/* Implementation of LineArena */
+
+LineArena::LineArena(Arena &pool) : pool(&pool) {}
+
+LineArena::LineArena(LineArena &&other) noexcept : pool(other.pool), head(other.head), used(other.used) {
+    other.head = nullptr;
+}
+
+LineArena &LineArena::operator=(LineArena &&other) noexcept {
+    if (this != &other) {
+        clear();
+        pool = other.pool;
+        head = other.head;
+        used = other.used;
+        other.head = nullptr;
+    }
+    return *this;
+}
+
+LineArena::~LineArena() {
+    clear();
+}
+
+/*
+ * Implementation notes: allocate
+ * ------------------------------
+ * Each chunk starts with the link to the previous chunk of the line;
+ * the rest is filled front to back.  Sizes are rounded up to pointer
+ * alignment, which is all that Statement and Expression nodes need.
+ */
+
+void *LineArena::allocate(size_t size) {
+    size = (size + alignof(void *) - 1) & ~(alignof(void *) - 1);
+    if (pool == nullptr || size > Arena::CHUNK_SIZE - sizeof(Chunk)) return nullptr;
+    if (head == nullptr || used + size > Arena::CHUNK_SIZE) {
+        auto *chunk = static_cast<Chunk *>(pool->allocateChunk());
+        chunk->next = head;
+        head = chunk;
+        used = sizeof(Chunk);
+    }
+    void *result = reinterpret_cast<char *>(head) + used;
+    used += size;
+    return result;
+}
+
+void LineArena::clear() {
+    while (head != nullptr) {
+        Chunk *next = head->next;
+        pool->freeChunk(head);
+        head = next;
+    }
+}
+
+/* Implementation of ArenaScope */
+
+ArenaScope::ArenaScope(LineArena &arena) : previous(currentArena) {
+    currentArena = &arena;
+}
+
+ArenaScope::~ArenaScope() {
+    currentArena = previous;
+}
+
+/*
+ * Implementation notes: allocateNode, freeNode
+ * --------------------------------------------
+ * Every node is preceded by a pointer-sized header that is nonzero for
+ * nodes living in an arena.
+ */
+
+static const size_t HEADER_SIZE = alignof(void *);
+
+void *allocateNode(size_t size) {
+    if (currentArena != nullptr) {
+        char *block = static_cast<char *>(currentArena->allocate(size + HEADER_SIZE));
+        if (block != nullptr) {
+            *reinterpret_cast<size_t *>(block) = 1;
+            stats.arenaAllocations++;
+            return block + HEADER_SIZE;
+        }
+    }
+    char *block = static_cast<char *>(::operator new(size + HEADER_SIZE));
+    *reinterpret_cast<size_t *>(block) = 0;
+    stats.heapAllocations++;
+    return block + HEADER_SIZE;
+}
+
+void freeNode(void *p) {
+    if (p == nullptr) return;
+    char *block = static_cast<char *>(p) - HEADER_SIZE;
+    if (*reinterpret_cast<size_t *>(block) != 0) return;   //arena 里的结点随整块内存一起释放
+    stats.heapFrees++;
+    ::operator delete(block);
+}
@@ -0,0 +1,194 @@
+/*
+ * File: arena.h
+ * -------------
+ * This interface exports the allocators used for the parsed form of a
+ * program.  Each Program owns an Arena, a pool of fixed-size chunks
+ * carved out of large slabs.  Each program line owns a LineArena, a
+ * chain of chunks from that pool into which the line's Statement and
+ * Expression nodes are bump-allocated, so the nodes of one line are
+ * adjacent in memory.  Replacing a line returns its chunks to the pool
+ * and CLEAR frees the slabs in bulk.
+ */
+
+#ifndef _arena_h
+#define _arena_h
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * Type: AllocationStats
+ * ---------------------
+ * Counters for the allocation of Statement and Expression nodes.
+ * heapAllocations and heapFrees count calls into the global allocator
+ * for single nodes, arenaAllocations counts nodes placed in a line
+ * arena, and slabAllocations/slabFrees count the arena's own calls
+ * into the global allocator.
+ */
+
+struct AllocationStats {
+    long heapAllocations = 0;
+    long heapFrees = 0;
+    long arenaAllocations = 0;
+    long slabAllocations = 0;
+    long slabFrees = 0;
+};
+
+/*
+ * Function: allocationStats
+ * Usage: const AllocationStats &stats = allocationStats();
+ * --------------------------------------------------------
+ * Returns the process-wide allocation counters.
+ */
+
+AllocationStats &allocationStats();
+
+/*
+ * Class: Arena
+ * ------------
+ * A pool of CHUNK_SIZE-byte chunks.  Chunks are handed out from a
+ * free list, or from the current slab of SLAB_CHUNKS chunks when the
+ * free list is empty.
+ */
+
+class Arena {
+
+public:
+
+    static const size_t CHUNK_SIZE = 256;
+    static const size_t SLAB_CHUNKS = 256;
+
+    Arena() = default;
+
+    ~Arena();
+
+    Arena(const Arena &) = delete;
+
+    Arena &operator=(const Arena &) = delete;
+
+/*
+ * Method: allocateChunk
+ * Usage: void *chunk = arena.allocateChunk();
+ * -------------------------------------------
+ * Returns CHUNK_SIZE bytes of pointer-aligned storage.
+ */
+
+    void *allocateChunk();
+
+/*
+ * Method: freeChunk
+ * Usage: arena.freeChunk(chunk);
+ * ------------------------------
+ * Puts a chunk back on the free list.
+ */
+
+    void freeChunk(void *chunk);
+
+/*
+ * Method: release
+ * Usage: arena.release();
+ * -----------------------
+ * Frees every slab at once.  No chunk of this arena may be used
+ * afterwards.
+ */
+
+    void release();
+
+private:
+
+    struct FreeChunk {
+        FreeChunk *next;
+    };
+
+    std::vector<char *> slabs;
+    size_t slabUsed = SLAB_CHUNKS;      //当前 slab 已分出的 chunk 数
+    FreeChunk *freeList = nullptr;
+
+};
+
+/*
+ * Class: LineArena
+ * ----------------
+ * The storage of one program line: a chain of chunks from an Arena
+ * with a bump pointer into the newest one.  A LineArena is movable
+ * but not copyable and gives its chunks back to the pool when it is
+ * destroyed.  It does not run destructors; the owner deletes the
+ * nodes first, which for arena nodes frees nothing.
+ */
+
+class LineArena {
+
+public:
+
+    LineArena() = default;
+
+    explicit LineArena(Arena &pool);
+
+    LineArena(LineArena &&other) noexcept;
+
+    LineArena &operator=(LineArena &&other) noexcept;
+
+    ~LineArena();
+
+/*
+ * Method: allocate
+ * Usage: void *p = arena.allocate(size);
+ * --------------------------------------
+ * Returns pointer-aligned storage for size bytes, or nullptr if the
+ * request does not fit in a chunk or the arena has no pool.
+ */
+
+    void *allocate(size_t size);
+
+private:
+
+    struct Chunk {
+        Chunk *next;
+    };
+
+    Arena *pool = nullptr;
+    Chunk *head = nullptr;
+    size_t used = 0;
+
+    void clear();
+
+};
+
+/*
+ * Class: ArenaScope
+ * -----------------
+ * While an ArenaScope is alive, Statement and Expression nodes created
+ * with new on the same thread are placed in its LineArena.  Scopes
+ * nest; the previous arena is restored by the destructor.
+ */
+
+class ArenaScope {
+
+public:
+
+    explicit ArenaScope(LineArena &arena);
+
+    ~ArenaScope();
+
+private:
+
+    LineArena *previous;
+
+};
+
+/*
+ * Functions: allocateNode, freeNode
+ * Usage: void *p = allocateNode(size);
+ *        freeNode(p);
+ * ------------------------------------
+ * The operator new and operator delete of Statement and Expression.
+ * A node goes into the current ArenaScope if there is one and it fits,
+ * otherwise onto the heap; a small header records which, so that
+ * freeNode only returns heap nodes to the global allocator.
+ */
+
+void *allocateNode(size_t size);
+
+void freeNode(void *p);
+
+#endif
@@ -0,0 +1,90 @@
+/*
+ * File: batch.cpp
+ * ---------------
+ * This file implements runBatch.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "batch.hpp"
+#include "output.hpp"
+#include "Utils/error.hpp"
+
+/*
+ * Implementation notes: runBatch
+ * ------------------------------
+ * The program is prepared once, so that compiling and linking are done
+ * before any thread starts; after that the threads only read it.  Each
+ * worker keeps one EvalState and one capturing OutputBuffer and reuses
+ * them for every set it takes, assigning the initial state afresh each
+ * time.  Sets are handed out through an atomic counter.  The calling
+ * thread prints the finished outputs in order and frees each one as it
+ * goes, so a slow set holds back printing but not the workers.
+ */
+
+int runBatch(Program &program, const EvalState &state, std::vector<InputData> &sets, int threads) {
+    program.prepare();
+    const Program &shared = program;
+    const size_t count = sets.size();
+    if (threads <= 0) threads = int(std::max(1u, std::thread::hardware_concurrency()));
+    if (size_t(threads) > count) threads = int(std::max<size_t>(count, 1));
+
+    std::vector<std::string> outputs(count);
+    std::vector<char> done(count, 0);
+    std::atomic<size_t> next{0};
+    std::atomic<int> failures{0};
+    std::mutex lock;
+    std::condition_variable finished;
+
+    auto worker = [&] {
+        EvalState local;
+        std::string text;
+        auto buffer = std::make_unique<OutputBuffer>(text);   //64 KiB，不放在线程栈上
+        while (true) {
+            size_t i = next++;
+            if (i >= count) break;
+            local = state;
+            local.setInputData(&sets[i]);
+            {
+                OutputScope scope(*buffer);
+                RunStats stats;
+                try {
+                    EvalStatus status = shared.run(local, stats);
+                    if (status != EVAL_OK) {
+                        output().printLine(statusMessage(status));
+                        failures++;
+                    }
+                } catch (ErrorException &ex) {
+                    output().printLine(ex.getMessage());
+                    failures++;
+                }
+            }
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                outputs[i] = std::move(text);
+                done[i] = 1;
+            }
+            finished.notify_one();
+            text.clear();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) pool.emplace_back(worker);
+    for (size_t i = 0; i < count; i++) {
+        std::string text;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            finished.wait(guard, [&] { return done[i] != 0; });
+            text = std::move(outputs[i]);
+        }
+        output().printText(text);
+    }
+    for (std::thread &thread: pool) thread.join();
+    return failures;
+}
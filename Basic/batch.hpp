@@ -0,0 +1,33 @@
+/*
+ * File: batch.h
+ * -------------
+ * This interface exports runBatch, which runs one program over many
+ * independent input sets in parallel.  It is behind the --batch option.
+ */
+
+#ifndef _batch_h
+#define _batch_h
+
+#include <vector>
+#include "evalstate.hpp"
+#include "inputdata.hpp"
+#include "program.hpp"
+
+/*
+ * Function: runBatch
+ * Usage: int failures = runBatch(program, state, sets, threads);
+ * --------------------------------------------------------------
+ * Runs the program once for every input set, on up to threads worker
+ * threads (all hardware threads if threads is 0).  Each run starts
+ * from a copy of state, takes its INPUT values from its own set and
+ * prints into its own buffer; a run stopped by an error ends with the
+ * message RUN would print.  The outputs are written to output() in the
+ * order of the sets, each as soon as it and all earlier ones are done.
+ * The program is shared by all threads and is not changed while they
+ * run.  Profiling does not apply; limits apply to every run.  Returns
+ * the number of runs that stopped with an error.
+ */
+
+int runBatch(Program &program, const EvalState &state, std::vector<InputData> &sets, int threads);
+
+#endif
@@ -0,0 +1,171 @@
+/*
+ * File: bytecode.cpp
+ * ------------------
+ * This file implements the bytecode compiler declared in bytecode.h.
+ */
+
+#include <algorithm>
+#include <map>
+#include "bytecode.hpp"
+
+
+/*
+ * Implementation notes: findLine, nextLinePc
+ * ------------------------------------------
+ * The lines table is sorted by pc, so both lookups are binary searches.
+ * Several lines may start at the same pc (REM lines emit no code); the
+ * last of them is the one whose code actually follows.
+ */
+
+const LineInfo *Bytecode::findLine(int pc) const {
+    auto it = std::upper_bound(lines.begin(), lines.end(), pc,
+                               [](int value, const LineInfo &info) { return value < info.pc; });
+    if (it == lines.begin()) return nullptr;
+    return &*(it - 1);
+}
+
+int Bytecode::nextLinePc(const LineInfo *info) const {
+    for (const LineInfo *next = info + 1; next != lines.data() + lines.size(); next++) {
+        if (next->pc > info->pc) return next->pc;
+    }
+    return int(code.size()) - 2;   //指向末尾的 OP_HALT
+}
+
+/*
+ * Implementation notes: compile
+ * -----------------------------
+ * The program is compiled in line-number order.  Every jump records a
+ * fixup that is patched once all line start offsets are known; a
+ * GOTO to a missing line becomes OP_LINE_ERROR and a conditional jump
+ * to a missing line gets the NO_TARGET operand.  Jumps land on the
+ * start of a line, so with countSteps they land on its OP_LINE and
+ * every executed statement is counted once.
+ */
+
+Bytecode *BytecodeCompiler::compile(Program &program, bool countSteps) {
+    out = new Bytecode;
+    fixups.clear();
+    depth = 0;
+    std::map<int, int> linePc;
+    for (auto it = program.program_map.begin(); it != program.program_map.end(); it++) {
+        Statement *stmt = it->second.stmt;
+        int pc = int(out->code.size());
+        linePc[it->first] = pc;
+        if (stmt == nullptr) continue;
+        out->lines.push_back({it->first, pc, stmt->getType()});
+        if (countSteps) emit(OP_LINE, it->first);
+        compileStatement(stmt);
+    }
+    emit(OP_HALT);
+    for (const Fixup &fixup: fixups) {
+        auto target = linePc.find(fixup.lineNumber);
+        if (target != linePc.end()) {
+            out->code[fixup.operandPc] = target->second;
+        } else if (out->code[fixup.operandPc - 1] == OP_JUMP) {
+            out->code[fixup.operandPc - 1] = OP_LINE_ERROR;
+        } else {
+            out->code[fixup.operandPc] = NO_TARGET;
+        }
+    }
+    Bytecode *result = out;
+    out = nullptr;
+    return result;
+}
+
+void BytecodeCompiler::compileStatement(Statement *stmt) {
+    switch (stmt->getType()) {
+        case REM_STMT:
+            break;
+        case LET_STMT: {
+            auto *let = (LetStatement *) stmt;
+            compileExp(let->getExp());
+            emit(OP_STORE, let->getSlot());
+            adjustDepth(-1);
+            break;
+        }
+        case PRINT_STMT:
+            compileExp(((PrintStatement *) stmt)->getExp());
+            emit(OP_PRINT);
+            adjustDepth(-1);
+            break;
+        case INPUT_STMT:
+            emit(OP_INPUT, ((InputStatement *) stmt)->getSlot());
+            break;
+        case END_STMT:
+            emit(OP_HALT);
+            break;
+        case GOTO_STMT:
+            emitJump(OP_JUMP, ((GotoStatement *) stmt)->getTarget());
+            break;
+        case IF_STMT: {
+            auto *branch = (IfStatement *) stmt;
+            CompoundExp *condition = branch->getCondition();
+            compileExp(condition->getLHS());
+            compileExp(condition->getRHS());
+            OperatorType op = condition->getOperator();
+            OpCode jump = op == EQUAL_OP ? OP_JUMP_EQ : op == LESS_OP ? OP_JUMP_LT : OP_JUMP_GT;
+            emitJump(jump, branch->getTarget());
+            adjustDepth(-2);
+            break;
+        }
+    }
+}
+
+/*
+ * Implementation notes: compileExp
+ * --------------------------------
+ * Operands are evaluated strictly left to right, each exactly once.
+ * An assignment to an illegal target is compiled into an OP_FAIL at
+ * the point where the tree evaluator would report it.
+ */
+
+void BytecodeCompiler::compileExp(Expression *exp) {
+    switch (exp->getType()) {
+        case CONSTANT:
+            emit(OP_CONST, ((ConstantExp *) exp)->getValue());
+            adjustDepth(1);
+            break;
+        case IDENTIFIER:
+            emit(OP_LOAD, ((IdentifierExp *) exp)->getSlot());
+            adjustDepth(1);
+            break;
+        case COMPOUND: {
+            auto *compound = (CompoundExp *) exp;
+            OperatorType op = compound->getOperator();
+            if (op == ASSIGN_OP) {
+                EvalStatus target = ((AssignExp *) compound)->getTargetStatus();
+                if (target != EVAL_OK) {
+                    emit(OP_FAIL, target);
+                    adjustDepth(1);
+                } else {
+                    compileExp(compound->getRHS());
+                    emit(OP_ASSIGN, ((IdentifierExp *) compound->getLHS())->getSlot());
+                }
+                break;
+            }
+            compileExp(compound->getLHS());
+            compileExp(compound->getRHS());
+            if (op == ADD_OP) emit(OP_ADD);
+            else if (op == SUB_OP) emit(OP_SUB);
+            else if (op == MUL_OP) emit(OP_MUL);
+            else emit(OP_DIV);
+            adjustDepth(-1);
+            break;
+        }
+    }
+}
+
+void BytecodeCompiler::emit(OpCode op, int operand) {
+    out->code.push_back(op);
+    out->code.push_back(operand);
+}
+
+void BytecodeCompiler::emitJump(OpCode op, int lineNumber) {
+    emit(op, NO_TARGET);
+    fixups.push_back({int(out->code.size()) - 1, lineNumber});
+}
+
+void BytecodeCompiler::adjustDepth(int delta) {
+    depth += delta;
+    if (depth > out->maxStack) out->maxStack = depth;
+}
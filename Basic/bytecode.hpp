@@ -0,0 +1,156 @@
+/*
+ * File: bytecode.h
+ * ----------------
+ * This interface exports the linear bytecode representation of a
+ * BASIC program together with the compiler that translates the
+ * parsed Statement/Expression trees stored in a Program into it.
+ * The bytecode is executed by the VirtualMachine class in vm.h.
+ */
+
+#ifndef _bytecode_h
+#define _bytecode_h
+
+#include <string>
+#include <vector>
+#include "exp.hpp"
+#include "statement.hpp"
+#include "program.hpp"
+
+/*
+ * Type: OpCode
+ * ------------
+ * The instruction set of the stack machine.  Every instruction is
+ * stored as an opcode followed by exactly one integer operand, so the
+ * program counter always advances by two.  Instructions that do not
+ * need an operand store 0.
+ *
+ *   OP_CONST n      push n
+ *   OP_LOAD v       push slot v ("VARIABLE NOT DEFINED" if unset)
+ *   OP_STORE v      pop into variable v              (LET)
+ *   OP_ASSIGN v     store top into variable v, keep it (= in expressions)
+ *   OP_ADD .. OP_DIV  pop rhs and lhs, push lhs op rhs
+ *   OP_FAIL s       fail with EvalStatus s at run time
+ *   OP_PRINT        pop and print
+ *   OP_INPUT v      prompt and read variable v
+ *   OP_JUMP pc      continue at pc                   (GOTO)
+ *   OP_JUMP_EQ pc   pop rhs and lhs, jump if lhs = rhs (IF ... THEN)
+ *   OP_JUMP_LT pc   pop rhs and lhs, jump if lhs < rhs
+ *   OP_JUMP_GT pc   pop rhs and lhs, jump if lhs > rhs
+ *   OP_LINE_ERROR   print "LINE NUMBER ERROR" and fall through
+ *   OP_LINE n       count a statement of line n against the limits
+ *   OP_HALT         stop the program                 (END, end of code)
+ *
+ * A conditional jump whose target line does not exist is compiled
+ * with the operand NO_TARGET and reports "LINE NUMBER ERROR" when
+ * the branch is taken.  OP_LINE only appears in code compiled for a
+ * limited RUN, at the start of every line.
+ */
+
+enum OpCode {
+    OP_CONST, OP_LOAD, OP_STORE, OP_ASSIGN,
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_FAIL,
+    OP_PRINT, OP_INPUT,
+    OP_JUMP, OP_JUMP_EQ, OP_JUMP_LT, OP_JUMP_GT, OP_LINE_ERROR,
+    OP_LINE, OP_HALT
+};
+
+const int NO_TARGET = -1;
+
+/*
+ * Type: LineInfo
+ * --------------
+ * Records where the code for one program line starts.  The table is
+ * sorted by pc and is consulted only off the hot path, when the VM
+ * has to decide how a run-time error inside a line is reported.
+ */
+
+struct LineInfo {
+    int lineNumber;
+    int pc;
+    StatementType type;
+};
+
+/*
+ * Class: Bytecode
+ * ---------------
+ * The compiled form of a whole program.  Variable operands are the
+ * EvalState slots bound by the resolve pass.
+ */
+
+class Bytecode {
+
+public:
+
+    std::vector<int> code;
+    std::vector<LineInfo> lines;
+    int maxStack = 0;
+
+/*
+ * Method: findLine
+ * Usage: const LineInfo *info = bytecode.findLine(pc);
+ * ----------------------------------------------------
+ * Returns the line whose code contains pc, or nullptr if pc lies
+ * outside every line.
+ */
+
+    const LineInfo *findLine(int pc) const;
+
+/*
+ * Method: nextLinePc
+ * Usage: int pc = bytecode.nextLinePc(info);
+ * ------------------------------------------
+ * Returns the pc at which the line following info starts.
+ */
+
+    int nextLinePc(const LineInfo *info) const;
+
+};
+
+/*
+ * Class: BytecodeCompiler
+ * -----------------------
+ * Translates the parsed statements of a Program into a Bytecode
+ * object.  Jump targets are resolved to code offsets once all lines
+ * have been emitted.
+ */
+
+class BytecodeCompiler {
+
+public:
+
+/*
+ * Method: compile
+ * Usage: Bytecode *code = BytecodeCompiler().compile(program);
+ *        Bytecode *code = BytecodeCompiler().compile(program, true);
+ * -------------------------------------------------------------------
+ * Returns a newly allocated Bytecode for the program.  If countSteps
+ * is true, every line starts with OP_LINE, and the code must be run
+ * with a RunLimiter.  The caller owns the result.
+ */
+
+    Bytecode *compile(Program &program, bool countSteps = false);
+
+private:
+
+    struct Fixup {
+        int operandPc;
+        int lineNumber;
+    };
+
+    Bytecode *out = nullptr;
+    std::vector<Fixup> fixups;
+    int depth = 0;
+
+    void compileStatement(Statement *stmt);
+
+    void compileExp(Expression *exp);
+
+    void emit(OpCode op, int operand = 0);
+
+    void emitJump(OpCode op, int lineNumber);
+
+    void adjustDepth(int delta);
+
+};
+
+#endif
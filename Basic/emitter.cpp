@@ -0,0 +1,296 @@
+/*
+ * File: emitter.cpp
+ * -----------------
+ * This file implements the SourceEmitter class.
+ */
+
+#include <algorithm>
+#include <climits>
+#include "emitter.hpp"
+
+/*
+ * Implementation notes: runtime
+ * -----------------------------
+ * The support code copied into every generated file.  Arithmetic wraps
+ * like the interpreter's int arithmetic does on the machines it runs
+ * on, and readValue repeats InputStatement::readValue, including the
+ * message of the stringToInteger error that ends the run.  The
+ * functions are inline, so that a program that does not use one of
+ * them still builds without warnings.
+ */
+
+static const char *const RUNTIME =
+        "#include <iostream>\n"
+        "#include <sstream>\n"
+        "#include <string>\n"
+        "\n"
+        "inline int add(int a, int b) { return int(unsigned(a) + unsigned(b)); }\n"
+        "inline int sub(int a, int b) { return int(unsigned(a) - unsigned(b)); }\n"
+        "inline int mul(int a, int b) { return int(unsigned(a) * unsigned(b)); }\n"
+        "\n"
+        "inline bool legalInput(const std::string &a) {\n"
+        "    for (char c: a) {\n"
+        "        if (!(('0' <= c && c <= '9') || c == '-')) return false;\n"
+        "    }\n"
+        "    return true;\n"
+        "}\n"
+        "\n"
+        "inline bool readValue(int &result) {\n"
+        "    std::cout << \" ? \";\n"
+        "    std::string value;\n"
+        "    std::getline(std::cin, value);\n"
+        "    while (!legalInput(value)) {\n"
+        "        std::cout << \"INVALID NUMBER\\n\";\n"
+        "        std::cout << \" ? \";\n"
+        "        std::getline(std::cin, value);\n"
+        "    }\n"
+        "    std::istringstream stream(value);\n"
+        "    stream >> result;\n"
+        "    if (!stream.eof()) stream >> std::ws;\n"
+        "    if (stream.fail() || !stream.eof()) {\n"
+        "        std::cout << \"stringToInteger: Illegal integer format (\" << value << \")\\n\";\n"
+        "        return false;\n"
+        "    }\n"
+        "    return true;\n"
+        "}\n"
+        "\n";
+
+static std::string label(int lineNumber) {
+    return "L" + std::to_string(lineNumber);
+}
+
+static std::string literal(int value) {
+    if (value == INT_MIN) return "(-2147483647 - 1)";
+    return std::to_string(value);
+}
+
+/*
+ * Implementation notes: emit
+ * --------------------------
+ * A first pass collects the lines some GOTO or IF jumps to and the
+ * variables some expression reads, so that the output builds cleanly
+ * with -Wall: only those lines get a label, and a variable that is
+ * never read is neither declared nor stored.  The label of the line
+ * after an IF is added when a failure inside the IF jumps to it, which
+ * is always before that line is written.  The body is generated before
+ * the declarations at the top of main, so that the set of variables is
+ * known by then.  Declaring everything before the first label keeps
+ * every goto legal in C++, since no jump can skip an initialization.
+ */
+
+void SourceEmitter::emit(Program &program, std::ostream &out) {
+    body.str("");
+    variables.clear();
+    reads.clear();
+    targets.clear();
+    temps = 0;
+    for (auto &entry: program.program_map) {
+        Statement *stmt = entry.second.stmt;
+        if (stmt == nullptr) continue;
+        int target = 0;
+        if (stmt->getType() == GOTO_STMT) target = ((GotoStatement *) stmt)->getTarget();
+        if (stmt->getType() == IF_STMT) target = ((IfStatement *) stmt)->getTarget();
+        if (program.program_map.count(target)) targets.insert(label(target));
+        if (stmt->getType() == LET_STMT) collectReads(((LetStatement *) stmt)->getExp());
+        if (stmt->getType() == PRINT_STMT) collectReads(((PrintStatement *) stmt)->getExp());
+        if (stmt->getType() == IF_STMT) collectReads(((IfStatement *) stmt)->getCondition());
+    }
+    for (auto it = program.program_map.begin(); it != program.program_map.end(); it++) {
+        auto next = std::next(it);
+        std::string source = it->second.source_line;
+        std::replace(source.begin(), source.end(), '\\', '/');   //注释行尾的反斜杠会续行
+        std::string name = label(it->first);
+        if (targets.count(name)) {
+            body << name << ":   // " << source << "\n";
+        } else {
+            body << "    // " << source << "\n";
+        }
+        if (it->second.stmt == nullptr) continue;
+        if (it->second.stmt->getType() == IF_STMT) {   //IF 中出错：报错后执行下一行
+            failTarget = next == program.program_map.end() ? "L_end" : label(next->first);
+        } else {
+            failTarget.clear();
+        }
+        body << "    {\n";
+        emitStatement(program, it->second.stmt);
+        body << "    }\n";
+    }
+    if (targets.count("L_end")) body << "L_end:\n";
+    body << "    return 0;\n";
+
+    out << "// Generated by COMPILE from a BASIC program.\n\n" << RUNTIME;
+    out << "int main() {\n"
+        << "    std::ios::sync_with_stdio(false);\n";
+    for (const std::string &name: variables) {
+        out << "    int v_" << name << " = 0;\n";
+        if (reads.count(name)) out << "    bool d_" << name << " = false;\n";
+    }
+    out << body.str() << "}\n";
+}
+
+void SourceEmitter::collectReads(Expression *exp) {
+    if (exp->getType() == IDENTIFIER) reads.insert(((IdentifierExp *) exp)->getName());
+    if (exp->getType() != COMPOUND) return;
+    auto *compound = (CompoundExp *) exp;
+    if (compound->getOperator() == ASSIGN_OP) {   //赋值的左边不是读取；目标非法时右边不会求值
+        if (((AssignExp *) compound)->getTargetStatus() == EVAL_OK) collectReads(compound->getRHS());
+        return;
+    }
+    collectReads(compound->getLHS());
+    collectReads(compound->getRHS());
+}
+
+void SourceEmitter::emitStatement(Program &program, Statement *stmt) {
+    switch (stmt->getType()) {
+        case REM_STMT:
+            break;
+        case LET_STMT: {
+            auto *let = (LetStatement *) stmt;
+            emitStore(let->getVar(), emitExp(let->getExp()));
+            break;
+        }
+        case PRINT_STMT: {
+            std::string value = emitExp(((PrintStatement *) stmt)->getExp());
+            body << "        std::cout << " << value << " << '\\n';\n";
+            break;
+        }
+        case INPUT_STMT: {
+            const std::string &var = ((InputStatement *) stmt)->getVar();
+            variables.insert(var);
+            body << "        if (!readValue(v_" << var << ")) return 0;\n";
+            if (reads.count(var)) body << "        d_" << var << " = true;\n";
+            break;
+        }
+        case END_STMT:
+            body << "        return 0;\n";
+            break;
+        case GOTO_STMT: {
+            int target = ((GotoStatement *) stmt)->getTarget();
+            if (program.program_map.count(target)) {
+                body << "        goto " << label(target) << ";\n";
+            } else {
+                body << "        std::cout << \"LINE NUMBER ERROR\\n\";\n";
+            }
+            break;
+        }
+        case IF_STMT: {
+            auto *branch = (IfStatement *) stmt;
+            CompoundExp *condition = branch->getCondition();
+            std::string lhs = emitExp(condition->getLHS());
+            std::string rhs = emitExp(condition->getRHS());
+            OperatorType op = condition->getOperator();
+            const char *compare = op == EQUAL_OP ? " == " : op == LESS_OP ? " < " : " > ";
+            int target = branch->getTarget();
+            body << "        if (" << lhs << compare << rhs << ") ";
+            if (program.program_map.count(target)) {
+                body << "goto " << label(target) << ";\n";
+            } else {
+                body << "std::cout << \"LINE NUMBER ERROR\\n\";\n";
+            }
+            break;
+        }
+    }
+}
+
+/*
+ * Implementation notes: emitExp
+ * -----------------------------
+ * C++ does not fix the order in which operands are evaluated, so every
+ * subexpression is computed into its own temporary, strictly left to
+ * right, and each check is made at the point where the tree evaluator
+ * would make it.  Variables are copied when they are read because a
+ * later assignment in the same expression may change them.
+ */
+
+std::string SourceEmitter::emitExp(Expression *exp) {
+    switch (exp->getType()) {
+        case CONSTANT:
+            return literal(((ConstantExp *) exp)->getValue());
+        case IDENTIFIER: {
+            std::string name = ((IdentifierExp *) exp)->getName();
+            variables.insert(name);
+            body << "        if (!d_" << name << ") ";
+            emitFail(EVAL_UNDEFINED_VARIABLE);
+            std::string temp = newTemp();
+            body << "        int " << temp << " = v_" << name << ";\n";
+            return temp;
+        }
+        case COMPOUND:
+            break;
+    }
+    auto *compound = (CompoundExp *) exp;
+    OperatorType op = compound->getOperator();
+    if (op == ASSIGN_OP) {
+        EvalStatus target = ((AssignExp *) compound)->getTargetStatus();
+        if (target != EVAL_OK) {
+            body << "        ";
+            emitFail(target);
+            return "0";
+        }
+        std::string value = emitExp(compound->getRHS());
+        emitStore(((IdentifierExp *) compound->getLHS())->getName(), value);
+        return value;
+    }
+    std::string lhs = emitExp(compound->getLHS());
+    std::string rhs = emitExp(compound->getRHS());
+    std::string temp = newTemp();
+    switch (op) {
+        case ADD_OP:
+            body << "        int " << temp << " = add(" << lhs << ", " << rhs << ");\n";
+            break;
+        case SUB_OP:
+            body << "        int " << temp << " = sub(" << lhs << ", " << rhs << ");\n";
+            break;
+        case MUL_OP:
+            body << "        int " << temp << " = mul(" << lhs << ", " << rhs << ");\n";
+            break;
+        default:
+            if (rhs == "0") {   //除数是常量 0：直接报错，不生成除法
+                discard(lhs);
+                body << "        ";
+                emitFail(EVAL_DIVIDE_BY_ZERO);
+                return "0";
+            }
+            body << "        if (" << rhs << " == 0) ";
+            emitFail(EVAL_DIVIDE_BY_ZERO);
+            body << "        int " << temp << " = " << lhs << " / " << rhs << ";\n";
+            break;
+    }
+    return temp;
+}
+
+/*
+ * Implementation notes: emitStore, discard
+ * ----------------------------------------
+ * A store to a variable that is never read is dropped, and a value
+ * that is dropped is cast to void when it is a temporary: its checks
+ * have been made already, but nothing reads it.
+ */
+
+void SourceEmitter::emitStore(const std::string &name, const std::string &value) {
+    if (!reads.count(name)) {
+        discard(value);
+        return;
+    }
+    variables.insert(name);
+    body << "        v_" << name << " = " << value << ";\n"
+         << "        d_" << name << " = true;\n";
+}
+
+void SourceEmitter::discard(const std::string &value) {
+    if (value[0] == 't') body << "        (void) " << value << ";\n";
+}
+
+void SourceEmitter::emitFail(EvalStatus status) {
+    body << "{ std::cout << \"" << statusMessage(status) << "\\n\"; ";
+    if (failTarget.empty()) {
+        body << "return 0; }\n";
+    } else {
+        targets.insert(failTarget);
+        body << "goto " << failTarget << "; }\n";
+    }
+}
+
+std::string SourceEmitter::newTemp() {
+    return "t" + std::to_string(++temps);
+}
@@ -0,0 +1,69 @@
+/*
+ * File: emitter.h
+ * ---------------
+ * This interface exports the SourceEmitter class, which translates a
+ * stored BASIC program into a standalone C++ source file.  Built with
+ * the system compiler, the file behaves like RUN on a fresh EvalState:
+ * it reads INPUT values from stdin and prints exactly what the
+ * interpreter prints, error messages included.
+ */
+
+#ifndef _emitter_h
+#define _emitter_h
+
+#include <ostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include "exp.hpp"
+#include "statement.hpp"
+#include "program.hpp"
+
+/*
+ * Class: SourceEmitter
+ * --------------------
+ * Walks the parsed statements of a Program in line-number order.  Each
+ * line becomes a block, labeled if some jump leads to it, variables
+ * become locals of main with a flag that records whether they are
+ * defined, and GOTO and IF ... THEN become goto.
+ */
+
+class SourceEmitter {
+
+public:
+
+/*
+ * Method: emit
+ * Usage: SourceEmitter().emit(program, out);
+ * ------------------------------------------
+ * Writes the C++ translation of program to out.
+ */
+
+    void emit(Program &program, std::ostream &out);
+
+private:
+
+    std::ostringstream body;
+    std::set<std::string> variables;
+    std::set<std::string> reads;        //被读取过的变量
+    std::set<std::string> targets;      //有跳转到达的标签
+    std::string failTarget;             //IF 中出错时跳到的标签，为空则结束程序
+    int temps = 0;
+
+    void collectReads(Expression *exp);
+
+    void emitStatement(Program &program, Statement *stmt);
+
+    std::string emitExp(Expression *exp);
+
+    void emitStore(const std::string &name, const std::string &value);
+
+    void discard(const std::string &value);
+
+    void emitFail(EvalStatus status);
+
+    std::string newTemp();
+
+};
+
+#endif
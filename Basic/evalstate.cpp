@@ -22,20 +22,44 @@ EvalState::~EvalState() {
     /* Empty */
 }
 
-void EvalState::setValue(std::string var, int value) {
-    if(isDefined(var)) symbolTable[var] = value;
-    else symbolTable.emplace(var,value);
+void EvalState::setValue(const std::string &var, int value) {
+    setValue(intern(var), value);
 }
 
-int EvalState::getValue(std::string var) {
-    if(isDefined(var)) return symbolTable[var];
-    else return 0;
+int EvalState::getValue(const std::string &var) {
+    auto it = slotTable.find(var);
+    if (it == slotTable.end() || !isDefined(it->second)) return 0;
+    return getValue(it->second);
 }
 
-bool EvalState::isDefined(std::string var) {
-    return symbolTable.find(var)!=symbolTable.end();
+bool EvalState::isDefined(const std::string &var) {
+    auto it = slotTable.find(var);
+    return it != slotTable.end() && isDefined(it->second);
+}
+
+int EvalState::intern(const std::string &name) {
+    auto it = slotTable.find(name);
+    if (it != slotTable.end()) return it->second;
+    int slot = int(names.size());
+    slotTable.emplace(name, slot);
+    names.push_back(name);
+    values.push_back(0);
+    defined.push_back(0);
+    return slot;
+}
+
+const std::string &EvalState::getName(int slot) const {
+    return names[slot];
 }
 
 void EvalState::Clear() {
-    symbolTable.clear();
-}
\ No newline at end of file
+    for (auto &flag: defined) flag = 0;
+}
+
+void EvalState::setInputData(InputData *data) {
+    inputData = data;
+}
+
+InputData *EvalState::getInputData() const {
+    return inputData;
+}
@@ -10,7 +10,10 @@
 #define _evalstate_h
 
 #include <string>
-#include <map>
+#include <vector>
+#include <unordered_map>
+
+class InputData;
 
 /*
  * Class: EvalState
@@ -20,8 +23,12 @@
  * environment that the evaluator may need to know.  In this
  * version, the only information maintained by the EvalState class
  * is a symbol table that maps variable names into their values.
- * In your implementation, you may include additional information
- * in the EvalState class.
+ *
+ * Variable names are interned into integer slots.  The parser binds
+ * every IdentifierExp and LetStatement to its slot once, so that the
+ * evaluator reads and writes a flat value array instead of searching
+ * the symbol table on each access.  The name-based methods remain for
+ * callers that only have the variable name at hand.
  */
 
 class EvalState {
@@ -53,7 +60,9 @@ public:
  * Sets the value associated with the specified var.
  */
 
-    void setValue(std::string var, int value);
+    void setValue(const std::string &var, int value);
+
+    void setValue(int slot, int value);
 
 /*
  * Method: getValue
@@ -62,7 +71,9 @@ public:
  * Returns the value associated with the specified variable.
  */
 
-    int getValue(std::string var);
+    int getValue(const std::string &var);
+
+    int getValue(int slot) const;
 
 /*
  * Method: isDefined
@@ -71,14 +82,100 @@ public:
  * Returns true if the specified variable is defined.
  */
 
-    bool isDefined(std::string var);
+    bool isDefined(const std::string &var);
+
+    bool isDefined(int slot) const;
+
+/*
+ * Method: intern
+ * Usage: int slot = state.intern(name);
+ * -------------------------------------
+ * Returns the slot of the named variable, allocating a new, undefined
+ * slot the first time a name is seen.  Slots stay valid across Clear.
+ */
+
+    int intern(const std::string &name);
+
+/*
+ * Method: getName
+ * Usage: string name = state.getName(slot);
+ * -----------------------------------------
+ * Returns the variable name that was interned into slot.
+ */
+
+    const std::string &getName(int slot) const;
+
+/*
+ * Methods: valueArray, definedArray
+ * Usage: int *values = state.valueArray();
+ * ----------------------------------------
+ * Return the slot arrays themselves, for native code that reads and
+ * writes variables without going through the accessors.  The pointers
+ * are invalidated when a new name is interned.
+ */
+
+    int *valueArray();
+
+    unsigned char *definedArray();
+
+/*
+ * Method: Clear
+ * Usage: state.Clear();
+ * ---------------------
+ * Marks every variable as undefined.
+ */
 
     void Clear();
 
+/*
+ * Methods: setInputData, getInputData
+ * Usage: state.setInputData(&data);
+ * ---------------------------------
+ * Sets where INPUT takes its values from: the values of data, or
+ * standard input if data is nullptr, which is the default.  The state
+ * does not own the data, and Clear leaves it in place.
+ */
+
+    void setInputData(InputData *data);
+
+    InputData *getInputData() const;
+
 private:
 
-    std::map<std::string, int> symbolTable;
+    std::unordered_map<std::string, int> slotTable;
+    std::vector<std::string> names;
+    std::vector<int> values;
+    std::vector<unsigned char> defined;
+    InputData *inputData = nullptr;
 
 };
 
+/*
+ * Implementation notes: slot access
+ * ---------------------------------
+ * The slot accessors are defined here so that they can be inlined
+ * into the evaluator and the VM.
+ */
+
+inline void EvalState::setValue(int slot, int value) {
+    values[slot] = value;
+    defined[slot] = 1;
+}
+
+inline int EvalState::getValue(int slot) const {
+    return values[slot];
+}
+
+inline bool EvalState::isDefined(int slot) const {
+    return defined[slot];
+}
+
+inline int *EvalState::valueArray() {
+    return values.data();
+}
+
+inline unsigned char *EvalState::definedArray() {
+    return defined.data();
+}
+
 #endif
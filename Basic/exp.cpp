@@ -4,6 +4,7 @@
  * This file implements the Expression class and its subclasses.
  */
 
+#include <climits>
 #include "exp.hpp"
 
 
@@ -17,6 +18,31 @@ Expression::Expression() = default;
 
 Expression::~Expression() = default;
 
+Expression *Expression::simplify() {
+    return this;
+}
+
+const char *statusMessage(EvalStatus status) {
+    switch (status) {
+        case EVAL_UNDEFINED_VARIABLE:
+            return "VARIABLE NOT DEFINED";
+        case EVAL_DIVIDE_BY_ZERO:
+            return "DIVIDE BY ZERO";
+        case EVAL_ILLEGAL_ASSIGNMENT:
+            return "Illegal variable in assignment";
+        case EVAL_SYNTAX_ERROR:
+            return "SYNTAX ERROR";
+        case EVAL_STEP_LIMIT:
+            return "STEP LIMIT EXCEEDED";
+        case EVAL_TIME_LIMIT:
+            return "TIME LIMIT EXCEEDED";
+        case EVAL_INPUT_EXHAUSTED:
+            return "INPUT DATA EXHAUSTED";
+        default:
+            return "";
+    }
+}
+
 /*
  * Implementation notes: the ConstantExp subclass
  * ----------------------------------------------
@@ -29,12 +55,11 @@ ConstantExp::ConstantExp(int value) {
     this->value = value;
 }
 
-int ConstantExp::eval_not_delete(EvalState &state, std::string &message) {
-    message="";
+int ConstantExp::eval_not_delete(EvalState &state, EvalStatus &status) const {
     return value;
 }
 
-int ConstantExp::eval(EvalState &state) {
+int ConstantExp::eval(EvalState &state) const {
     return value;
 }
 
@@ -50,8 +75,8 @@ int ConstantExp::getValue() const {
     return value;
 }
 
-std::string ConstantExp::component_eval(EvalState &state) {
-    return "";
+void ConstantExp::resolve(EvalState &state) {
+    /* Empty */
 }
 
 
@@ -68,26 +93,21 @@ IdentifierExp::IdentifierExp(std::string name) {
     this->name = name;
 }
 
-int IdentifierExp::eval(EvalState &state) {
-    if (!state.isDefined(name)) {
-        delete this;
-        error("VARIABLE NOT DEFINED");
-    }
-    return state.getValue(name);
+int IdentifierExp::eval(EvalState &state) const {
+    if (!state.isDefined(slot)) error("VARIABLE NOT DEFINED");
+    return state.getValue(slot);
 }
 
-int IdentifierExp::eval_not_delete(EvalState &state, std::string &message) {
-    if (!state.isDefined(name)) {
-        message = "VARIABLE NOT DEFINED";
+int IdentifierExp::eval_not_delete(EvalState &state, EvalStatus &status) const {
+    if (!state.isDefined(slot)) {
+        status = EVAL_UNDEFINED_VARIABLE;
         return -1;
     }
-    return state.getValue(name);
+    return state.getValue(slot);
 }
 
-
-std::string IdentifierExp::component_eval(EvalState &state) {
-    if (!state.isDefined(name)) return "VARIABLE NOT DEFINED";
-    return "";
+void IdentifierExp::resolve(EvalState &state) {
+    slot = state.intern(name);
 }
 
 std::string IdentifierExp::toString() {
@@ -102,6 +122,10 @@ std::string IdentifierExp::getName() {
     return name;
 }
 
+int IdentifierExp::getSlot() const {
+    return slot;
+}
+
 
 /*
  * Implementation notes: the CompoundExp subclass
@@ -111,7 +135,7 @@ std::string IdentifierExp::getName() {
  * evaluates the subexpressions recursively and then applies the operator.
  */
 
-CompoundExp::CompoundExp(std::string op, Expression *lhs, Expression *rhs) {
+CompoundExp::CompoundExp(OperatorType op, Expression *lhs, Expression *rhs) {
     this->op = op;
     this->lhs = lhs;
     this->rhs = rhs;
@@ -125,117 +149,65 @@ CompoundExp::~CompoundExp() {
 /*
  * Implementation notes: eval
  * --------------------------
- * The eval method for the compound expression case must check for the
- * assignment operator as a special case.  Unlike the arithmetic operators
- * the assignment operator does not evaluate its left operand.
+ * The operator-specific work lives in eval_not_delete of each subclass;
+ * eval only turns a failed status into an error.
  */
 
-int CompoundExp::eval(EvalState &state) {
-    if (op == "=") {
-        if (lhs->getType() != IDENTIFIER) {
-            delete this;
-            error("Illegal variable in assignment");
-        }
-        if (lhs->getType() == IDENTIFIER && lhs->toString() == "LET") {
-            delete this;
-            error("SYNTAX ERROR");
-        }
-        int val = rhs->eval(state);
-        state.setValue(((IdentifierExp *) lhs)->getName(), val);
-        return val;
-    }
-    std::string left_message, right_message;
-    left_message = lhs->component_eval(state);
-    right_message = rhs->component_eval(state);
-    if (!left_message.empty()) {
-        delete this;
-        error(left_message);
-    }
-    if (!right_message.empty()) {
-        delete this;
-        error(right_message);
-    }
-    int left = lhs->eval(state);
-    int right = rhs->eval(state);
-    if (op == "+") return left + right;
-    if (op == "-") return left - right;
-    if (op == "*") return left * right;
-    if (op == "/") {
-        if (right == 0) {
-            delete this;
-            error("DIVIDE BY ZERO");
-        }
-        return left / right;
-    }
-    return 0;
+int CompoundExp::eval(EvalState &state) const {
+    EvalStatus status = EVAL_OK;
+    int value = eval_not_delete(state, status);
+    if (status != EVAL_OK) error(statusMessage(status));
+    return value;
 }
 
-std::string CompoundExp::component_eval(EvalState &state) {
-    if (op == "=") {
-        if (lhs->getType() != IDENTIFIER) {
-            return "Illegal variable in assignment";
-        }
-        if (lhs->getType() == IDENTIFIER && lhs->toString() == "LET") {
-            return "SYNTAX ERROR";
-        }
-        return rhs->component_eval(state);
-    }
-//    int left = lhs->eval(state);
-    int right = rhs->eval(state);
-//    if (op == "+") return "";
-//    if (op == "-") return "";
-//    if (op == "*") return "";
-    if (op == "/") {
-        if (right == 0) {
-//            delete this;
-            return "DIVIDE BY ZERO";
-        }
-        return "";
-    }
-    return "";
-}
-
-int CompoundExp::eval_not_delete(EvalState &state, std::string &message) {
-    if (op == "=") {
-        if (lhs->getType() != IDENTIFIER) {
-            message="Illegal variable in assignment";
-            return -1;
-        }
-        if (lhs->getType() == IDENTIFIER && lhs->toString() == "LET") {
-           message="SYNTAX ERROR";
-            return -1;
-        }
-        int val = rhs->eval(state);
-        state.setValue(((IdentifierExp *) lhs)->getName(), val);
-        return val;
-    }
-    std::string left_message, right_message;
-    left_message = lhs->component_eval(state);
-    right_message = rhs->component_eval(state);
-    if (!left_message.empty()) {
-        message=left_message;
-        return -1;
-    }
-    if (!right_message.empty()) {
-        message=right_message;
-        return -1;
-    }
-    int left = lhs->eval(state);
-    int right = rhs->eval(state);
-    if (op == "+") return left + right;
-    if (op == "-") return left - right;
-    if (op == "*") return left * right;
-    if (op == "/") {
-        if (right == 0) {
-            message="DIVIDE BY ZERO";
-            return -1;
-        }
-        return left / right;
-    }
-    return 0;
+void CompoundExp::resolve(EvalState &state) {
+    lhs->resolve(state);
+    rhs->resolve(state);
+}
+
+/*
+ * Implementation notes: simplify
+ * ------------------------------
+ * The operands are simplified bottom-up.  The target of an assignment
+ * is left alone, because turning (x * 1) = 5 into x = 5 would make an
+ * illegal assignment legal.  Relations and assignments are not folded
+ * themselves; the operator subclasses below do the folding.  Sums,
+ * differences and products are folded in unsigned arithmetic, so that
+ * an overflowing constant wraps as it does at run time instead of
+ * being undefined in the parser.
+ */
+
+Expression *CompoundExp::simplify() {
+    if (op != ASSIGN_OP) lhs = lhs->simplify();
+    rhs = rhs->simplify();
+    return this;
+}
+
+bool CompoundExp::constantOperands(int &left, int &right) const {
+    if (lhs->getType() != CONSTANT || rhs->getType() != CONSTANT) return false;
+    left = ((ConstantExp *) lhs)->getValue();
+    right = ((ConstantExp *) rhs)->getValue();
+    return true;
+}
+
+bool CompoundExp::isConstant(Expression *exp, int value) {
+    return exp->getType() == CONSTANT && ((ConstantExp *) exp)->getValue() == value;
 }
+
+Expression *CompoundExp::foldTo(int value) {
+    delete this;
+    return new ConstantExp(value);
+}
+
+Expression *CompoundExp::replaceWith(Expression *operand) {
+    if (operand == lhs) lhs = nullptr;
+    else rhs = nullptr;
+    delete this;
+    return operand;
+}
+
 std::string CompoundExp::toString() {
-    return '(' + lhs->toString() + ' ' + op + ' ' + rhs->toString() + ')';
+    return '(' + lhs->toString() + ' ' + getOp() + ' ' + rhs->toString() + ')';
 }
 
 ExpressionType CompoundExp::getType() {
@@ -243,6 +215,11 @@ ExpressionType CompoundExp::getType() {
 }
 
 std::string CompoundExp::getOp() {
+    static const char *const SPELLINGS[] = {"=", "+", "-", "*", "/", "=", "<", ">"};
+    return SPELLINGS[op];
+}
+
+OperatorType CompoundExp::getOperator() const {
     return op;
 }
 
@@ -254,6 +231,146 @@ Expression *CompoundExp::getRHS() {
     return rhs;
 }
 
+/*
+ * Implementation notes: the binary subclasses
+ * -------------------------------------------
+ * Every binary operator evaluates its left operand, then its right
+ * operand, each exactly once, and returns as soon as either of them
+ * reports a failure.  The comparison subclasses used by IF follow the
+ * same pattern and yield 1 or 0.
+ */
+
+bool CompoundExp::evalOperands(EvalState &state, EvalStatus &status, int &left, int &right) const {
+    left = lhs->eval_not_delete(state, status);
+    if (status != EVAL_OK) return false;
+    right = rhs->eval_not_delete(state, status);
+    return status == EVAL_OK;
+}
+
+AddExp::AddExp(Expression *lhs, Expression *rhs) : CompoundExp(ADD_OP, lhs, rhs) {}
+
+int AddExp::eval_not_delete(EvalState &state, EvalStatus &status) const {
+    int left, right;
+    if (!evalOperands(state, status, left, right)) return -1;
+    return left + right;
+}
+
+Expression *AddExp::simplify() {
+    CompoundExp::simplify();
+    int left, right;
+    if (constantOperands(left, right)) return foldTo(int(unsigned(left) + unsigned(right)));
+    if (isConstant(rhs, 0)) return replaceWith(lhs);
+    if (isConstant(lhs, 0)) return replaceWith(rhs);
+    return this;
+}
+
+SubExp::SubExp(Expression *lhs, Expression *rhs) : CompoundExp(SUB_OP, lhs, rhs) {}
+
+int SubExp::eval_not_delete(EvalState &state, EvalStatus &status) const {
+    int left, right;
+    if (!evalOperands(state, status, left, right)) return -1;
+    return left - right;
+}
+
+Expression *SubExp::simplify() {
+    CompoundExp::simplify();
+    int left, right;
+    if (constantOperands(left, right)) return foldTo(int(unsigned(left) - unsigned(right)));
+    if (isConstant(rhs, 0)) return replaceWith(lhs);
+    return this;
+}
+
+MulExp::MulExp(Expression *lhs, Expression *rhs) : CompoundExp(MUL_OP, lhs, rhs) {}
+
+int MulExp::eval_not_delete(EvalState &state, EvalStatus &status) const {
+    int left, right;
+    if (!evalOperands(state, status, left, right)) return -1;
+    return left * right;
+}
+
+Expression *MulExp::simplify() {
+    CompoundExp::simplify();
+    int left, right;
+    if (constantOperands(left, right)) return foldTo(int(unsigned(left) * unsigned(right)));
+    if (isConstant(rhs, 1)) return replaceWith(lhs);
+    if (isConstant(lhs, 1)) return replaceWith(rhs);
+    return this;
+}
+
+DivExp::DivExp(Expression *lhs, Expression *rhs) : CompoundExp(DIV_OP, lhs, rhs) {}
+
+int DivExp::eval_not_delete(EvalState &state, EvalStatus &status) const {
+    int left, right;
+    if (!evalOperands(state, status, left, right)) return -1;
+    if (right == 0) {
+        status = EVAL_DIVIDE_BY_ZERO;
+        return -1;
+    }
+    return left / right;
+}
+
+Expression *DivExp::simplify() {
+    CompoundExp::simplify();
+    int left, right;
+    if (constantOperands(left, right) && right != 0 && !(left == INT_MIN && right == -1)) {
+        return foldTo(left / right);   //除以常数 0 留到运行时报 DIVIDE BY ZERO
+    }
+    if (isConstant(rhs, 1)) return replaceWith(lhs);
+    return this;
+}
+
+EqualExp::EqualExp(Expression *lhs, Expression *rhs) : CompoundExp(EQUAL_OP, lhs, rhs) {}
+
+int EqualExp::eval_not_delete(EvalState &state, EvalStatus &status) const {
+    int left, right;
+    if (!evalOperands(state, status, left, right)) return -1;
+    return left == right;
+}
+
+LessExp::LessExp(Expression *lhs, Expression *rhs) : CompoundExp(LESS_OP, lhs, rhs) {}
+
+int LessExp::eval_not_delete(EvalState &state, EvalStatus &status) const {
+    int left, right;
+    if (!evalOperands(state, status, left, right)) return -1;
+    return left < right;
+}
+
+GreaterExp::GreaterExp(Expression *lhs, Expression *rhs) : CompoundExp(GREATER_OP, lhs, rhs) {}
 
+int GreaterExp::eval_not_delete(EvalState &state, EvalStatus &status) const {
+    int left, right;
+    if (!evalOperands(state, status, left, right)) return -1;
+    return left > right;
+}
+
+/*
+ * Implementation notes: the AssignExp subclass
+ * --------------------------------------------
+ * The left operand is never evaluated.  Whether it is a legal target
+ * does not depend on the state, so the constructor decides it once.
+ */
 
+AssignExp::AssignExp(Expression *lhs, Expression *rhs) : CompoundExp(ASSIGN_OP, lhs, rhs) {
+    if (lhs->getType() != IDENTIFIER) {
+        target_status = EVAL_ILLEGAL_ASSIGNMENT;
+    } else if (lhs->toString() == "LET") {
+        target_status = EVAL_SYNTAX_ERROR;
+    } else {
+        target_status = EVAL_OK;
+    }
+}
 
+int AssignExp::eval_not_delete(EvalState &state, EvalStatus &status) const {
+    if (target_status != EVAL_OK) {
+        status = target_status;
+        return -1;
+    }
+    int val = rhs->eval_not_delete(state, status);
+    if (status != EVAL_OK) return -1;
+    state.setValue(((IdentifierExp *) lhs)->getSlot(), val);
+    return val;
+}
+
+EvalStatus AssignExp::getTargetStatus() const {
+    return target_status;
+}
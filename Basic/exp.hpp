@@ -10,6 +10,7 @@
 #define _exp_h
 
 #include <string>
+#include "arena.hpp"
 #include "Utils/error.hpp"
 #include "evalstate.hpp"
 #include "Utils/strlib.hpp"
@@ -25,6 +26,32 @@ enum ExpressionType {
     CONSTANT, IDENTIFIER, COMPOUND
 };
 
+/*
+ * Type: EvalStatus
+ * ----------------
+ * The outcome of evaluating an expression.  Evaluation stops at the
+ * first failing node, which stores its status in the out-parameter of
+ * eval_not_delete; the message text is looked up only when the error
+ * is reported, with statusMessage.  The two limit statuses are never
+ * produced by expressions; RUN returns them when a program exceeds the
+ * limits set with Program::setLimits.  EVAL_INPUT_EXHAUSTED comes from
+ * INPUT reading past the end of a data file.
+ */
+
+enum EvalStatus {
+    EVAL_OK, EVAL_UNDEFINED_VARIABLE, EVAL_DIVIDE_BY_ZERO, EVAL_ILLEGAL_ASSIGNMENT, EVAL_SYNTAX_ERROR,
+    EVAL_STEP_LIMIT, EVAL_TIME_LIMIT, EVAL_INPUT_EXHAUSTED
+};
+
+/*
+ * Function: statusMessage
+ * Usage: string msg = statusMessage(status);
+ * ------------------------------------------
+ * Returns the message the interpreter prints for a failed status.
+ */
+
+const char *statusMessage(EvalStatus status);
+
 /*
  * Class: Expression
  * -----------------
@@ -72,21 +99,68 @@ public:
 
     virtual ~Expression();
 
+/*
+ * Operators: new, delete
+ * Usage: Expression *exp = new ConstantExp(value);
+ * ------------------------------------------------
+ * Expression nodes are allocated through allocateNode, so that the
+ * nodes parsed for a program line are placed in that line's arena.
+ * Deleting an arena node runs its destructor but frees nothing.
+ */
+
+    static void *operator new(size_t size) { return allocateNode(size); }
+
+    static void operator delete(void *p) { freeNode(p); }
+
 /*
  * Method: eval
  * Usage: int value = exp->eval(state);
  * ------------------------------------
  * Evaluates this expression and returns its value in the context of
- * the specified EvalState object.
+ * the specified EvalState object.  A failure is reported by calling
+ * error; the expression itself is left intact and can be evaluated
+ * again.  Like eval_not_delete, eval never changes the tree, so one
+ * tree can be evaluated on several threads at once, each thread with
+ * its own EvalState.
  */
 
-    virtual int eval(EvalState &state) = 0;
+    virtual int eval(EvalState &state) const = 0;
 
+/*
+ * Method: eval_not_delete
+ * Usage: int value = exp->eval_not_delete(state, status);
+ * -------------------------------------------------------
+ * Evaluates this expression in a single left-to-right pass, visiting
+ * every node once.  status must be EVAL_OK on entry; if a node fails,
+ * status is set, the evaluation stops and the returned value is
+ * meaningless.  Unlike eval, this method never throws.
+ */
+
+    virtual int eval_not_delete(EvalState &state, EvalStatus &status) const = 0;
 
-    virtual std::string component_eval(EvalState &state) = 0;   //用于解决作为复合表达式中一侧的eval问题
+/*
+ * Method: resolve
+ * Usage: exp->resolve(state);
+ * ---------------------------
+ * Interns every variable that appears in this expression and binds
+ * the identifier nodes to their slots in state.  The parser runs this
+ * pass once per expression, before the expression is evaluated.
+ */
 
-    virtual int eval_not_delete(EvalState &state,std::string &message)=0;
+    virtual void resolve(EvalState &state) = 0;
+
+/*
+ * Method: simplify
+ * Usage: exp = exp->simplify();
+ * -----------------------------
+ * Returns an expression that evaluates to the same value and reports
+ * the same run-time errors, with constant subtrees folded and the
+ * identities x + 0, x - 0, x * 1 and x / 1 removed.  The receiver may
+ * be deleted, so only the returned pointer remains valid.  The default
+ * implementation returns the expression unchanged.
+ */
 
+    virtual Expression *simplify();
 
 
     /*
@@ -137,11 +211,11 @@ public:
  * base class and don't require additional documentation.
  */
 
-    virtual int eval(EvalState &state);
+    virtual int eval(EvalState &state) const;
 
-    virtual std::string component_eval(EvalState &state);
+    int eval_not_delete(EvalState &state, EvalStatus &status) const;
 
-    int eval_not_delete(EvalState &state,std::string &message);
+    virtual void resolve(EvalState &state);
 
     virtual std::string toString();
 
@@ -190,11 +264,11 @@ public:
  * base class and don't require additional documentation.
  */
 
-    virtual int eval(EvalState &state);
+    virtual int eval(EvalState &state) const;
 
-    int eval_not_delete(EvalState &state,std::string &message);
+    int eval_not_delete(EvalState &state, EvalStatus &status) const;
 
-    virtual std::string component_eval(EvalState &state);
+    virtual void resolve(EvalState &state);
 
     virtual std::string toString();
 
@@ -210,17 +284,41 @@ public:
 
     std::string getName();
 
+/*
+ * Method: getSlot
+ * Usage: int slot = ((IdentifierExp *) exp)->getSlot();
+ * -----------------------------------------------------
+ * Returns the slot bound by resolve, or -1 if resolve has not run.
+ */
+
+    int getSlot() const;
+
 private:
 
     std::string name;
+    int slot = -1;
 
 };
 
+/*
+ * Type: OperatorType
+ * ------------------
+ * This enumerated type identifies the operator of a CompoundExp.  The
+ * first five are produced by readE; the comparison operators appear
+ * only in the condition of an IF statement.
+ */
+
+enum OperatorType {
+    ASSIGN_OP, ADD_OP, SUB_OP, MUL_OP, DIV_OP, EQUAL_OP, LESS_OP, GREATER_OP
+};
+
 /*
  * Class: CompoundExp
  * ------------------
  * This subclass represents a compound expression consisting of
- * two subexpressions joined by an operator.
+ * two subexpressions joined by an operator.  Each operator has its
+ * own subclass below, so evaluating a node is a single virtual call
+ * and never inspects the operator.
  */
 
 class CompoundExp : public Expression {
@@ -229,14 +327,15 @@ public:
 
 /*
  * Constructor: CompoundExp
- * Usage: Expression *exp = new CompoundExp(op, lhs, rhs);
- * -------------------------------------------------------
+ * Usage: Expression *exp = new AddExp(lhs, rhs);
+ * ----------------------------------------------
  * The constructor initializes a new compound expression
  * which is composed of the operator (op) and the left and
- * right subexpression (lhs and rhs).
+ * right subexpression (lhs and rhs).  Clients create one of the
+ * operator subclasses, usually through makeCompoundExp in parser.h.
  */
 
-    CompoundExp(std::string op, Expression *lhs, Expression *rhs);
+    CompoundExp(OperatorType op, Expression *lhs, Expression *rhs);
 
 /*
  * Prototypes for the virtual methods
@@ -247,19 +346,20 @@ public:
 
     virtual ~CompoundExp();
 
-    virtual int eval(EvalState &state);
+    virtual int eval(EvalState &state) const;
 
-    int eval_not_delete(EvalState &state,std::string &message);
+    virtual void resolve(EvalState &state);
 
-    virtual std::string component_eval(EvalState &state);
+    virtual Expression *simplify();
 
     virtual std::string toString();
 
     virtual ExpressionType getType();
 
 /*
- * Methods: getOp, getLHS, getRHS
+ * Methods: getOp, getOperator, getLHS, getRHS
  * Usage: string op = ((CompoundExp *) exp)->getOp();
+ *        OperatorType type = ((CompoundExp *) exp)->getOperator();
  *        Expression *lhs = ((CompoundExp *) exp)->getLHS();
  *        Expression *rhs = ((CompoundExp *) exp)->getRHS();
  * ---------------------------------------------------------
@@ -269,15 +369,168 @@ public:
 
     std::string getOp();
 
+    OperatorType getOperator() const;
+
     Expression *getLHS();
 
     Expression *getRHS();
 
-private:
+protected:
+
+/*
+ * Method: evalOperands
+ * Usage: if (!evalOperands(state, status, left, right)) return -1;
+ * ----------------------------------------------------------------
+ * Evaluates the left and then the right operand.  Returns false as
+ * soon as one of them fails.
+ */
+
+    bool evalOperands(EvalState &state, EvalStatus &status, int &left, int &right) const;
+
+/*
+ * Methods: constantOperands, isConstant, foldTo, replaceWith
+ * ----------------------------------------------------------
+ * Helpers for the simplify methods of the operator subclasses.
+ * constantOperands reads both operand values if both are constants;
+ * isConstant tests one operand against a value.  foldTo and
+ * replaceWith delete this node and return, respectively, a new
+ * constant or the given operand, which is detached first.
+ */
+
+    bool constantOperands(int &left, int &right) const;
+
+    static bool isConstant(Expression *exp, int value);
 
-    std::string op;
+    Expression *foldTo(int value);
+
+    Expression *replaceWith(Expression *operand);
+
+    OperatorType op;
     Expression *lhs, *rhs;
 
 };
 
+/*
+ * Classes: AddExp, SubExp, MulExp, DivExp
+ * ---------------------------------------
+ * The arithmetic operators.  DivExp reports "DIVIDE BY ZERO", so a
+ * division by a constant zero is never folded.
+ */
+
+class AddExp : public CompoundExp {
+
+public:
+
+    AddExp(Expression *lhs, Expression *rhs);
+
+    int eval_not_delete(EvalState &state, EvalStatus &status) const;
+
+    Expression *simplify();
+
+};
+
+class SubExp : public CompoundExp {
+
+public:
+
+    SubExp(Expression *lhs, Expression *rhs);
+
+    int eval_not_delete(EvalState &state, EvalStatus &status) const;
+
+    Expression *simplify();
+
+};
+
+class MulExp : public CompoundExp {
+
+public:
+
+    MulExp(Expression *lhs, Expression *rhs);
+
+    int eval_not_delete(EvalState &state, EvalStatus &status) const;
+
+    Expression *simplify();
+
+};
+
+class DivExp : public CompoundExp {
+
+public:
+
+    DivExp(Expression *lhs, Expression *rhs);
+
+    int eval_not_delete(EvalState &state, EvalStatus &status) const;
+
+    Expression *simplify();
+
+};
+
+/*
+ * Class: AssignExp
+ * ----------------
+ * The assignment operator.  Unlike the arithmetic operators it does
+ * not evaluate its left operand, which must be an identifier.
+ */
+
+class AssignExp : public CompoundExp {
+
+public:
+
+    AssignExp(Expression *lhs, Expression *rhs);
+
+    int eval_not_delete(EvalState &state, EvalStatus &status) const;
+
+/*
+ * Method: getTargetStatus
+ * Usage: EvalStatus status = ((AssignExp *) exp)->getTargetStatus();
+ * ------------------------------------------------------------------
+ * Returns EVAL_OK if the left operand is a legal assignment target,
+ * or the status the assignment reports when it is evaluated.
+ */
+
+    EvalStatus getTargetStatus() const;
+
+private:
+
+    EvalStatus target_status;
+
+};
+
+/*
+ * Classes: EqualExp, LessExp, GreaterExp
+ * --------------------------------------
+ * The relations of an IF statement.  Each evaluates to 1 if the
+ * relation holds and 0 otherwise.
+ */
+
+class EqualExp : public CompoundExp {
+
+public:
+
+    EqualExp(Expression *lhs, Expression *rhs);
+
+    int eval_not_delete(EvalState &state, EvalStatus &status) const;
+
+};
+
+class LessExp : public CompoundExp {
+
+public:
+
+    LessExp(Expression *lhs, Expression *rhs);
+
+    int eval_not_delete(EvalState &state, EvalStatus &status) const;
+
+};
+
+class GreaterExp : public CompoundExp {
+
+public:
+
+    GreaterExp(Expression *lhs, Expression *rhs);
+
+    int eval_not_delete(EvalState &state, EvalStatus &status) const;
+
+};
+
 #endif
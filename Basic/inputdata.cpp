@@ -0,0 +1,95 @@
+/*
+ * File: inputdata.cpp
+ * -------------------
+ * This file implements the InputData class.
+ */
+
+#include <cctype>
+#include <charconv>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "inputdata.hpp"
+#include "Utils/error.hpp"
+
+/*
+ * Implementation notes: scanValues
+ * --------------------------------
+ * The file is mapped rather than read, and scanned once.  Each value
+ * is converted with from_chars straight out of the mapping, which must
+ * consume the whole token; that rejects the same strings INPUT rejects
+ * as an INVALID NUMBER or as an illegal integer format.  visit receives
+ * each value with the number of its line, so that load and loadSets can
+ * group the values as they need.
+ */
+
+template <typename Visit>
+static void scanValues(const char *path, Visit visit) {
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) < 0) {
+        if (fd >= 0) close(fd);
+        error("Cannot load data " + std::string(path));
+    }
+    size_t size = info.st_size;
+    const char *text = nullptr;
+    if (size > 0) {
+        void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            error("Cannot load data " + std::string(path));
+        }
+        madvise(data, size, MADV_SEQUENTIAL);
+        text = (const char *) data;
+    }
+    close(fd);
+
+    std::string bad;
+    int line = 1;
+    const char *p = text, *end = text + size;
+    while (p < end) {
+        if (isspace((unsigned char) *p)) {
+            if (*p++ == '\n') line++;
+            continue;
+        }
+        const char *start = p;
+        while (p < end && !isspace((unsigned char) *p)) p++;
+        int value = 0;
+        auto result = std::from_chars(start, p, value);
+        if (result.ec != std::errc() || result.ptr != p) {
+            bad = std::string(start, p);
+            break;
+        }
+        visit(value, line);
+    }
+    if (text != nullptr) munmap((void *) text, size);
+    if (!bad.empty()) {
+        error("Illegal integer format in " + std::string(path) + " line " + std::to_string(line) + " (" + bad + ")");
+    }
+}
+
+void InputData::load(const char *path) {
+    values.clear();
+    position = 0;
+    try {
+        scanValues(path, [this](int value, int) { values.push_back(value); });
+    } catch (ErrorException &) {
+        values.clear();
+        throw;
+    }
+}
+
+std::vector<InputData> InputData::loadSets(const char *path) {
+    std::vector<InputData> sets;
+    int last = 0;
+    scanValues(path, [&](int value, int line) {
+        if (line != last) {   //新的一行开始一个新的输入组
+            sets.emplace_back();
+            last = line;
+        }
+        sets.back().values.push_back(value);
+    });
+    return sets;
+}
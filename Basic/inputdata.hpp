@@ -0,0 +1,97 @@
+/*
+ * File: inputdata.h
+ * -----------------
+ * This interface exports the InputData class, a file of values for
+ * INPUT.  With --data, INPUT takes its values from the file instead of
+ * standard input, so that large data sets can be pushed through a
+ * program in a single RUN without an interactive prompt per value.
+ */
+
+#ifndef _inputdata_h
+#define _inputdata_h
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/*
+ * Class: InputData
+ * ----------------
+ * The values of a data file, parsed in one pass when the file is
+ * loaded, and a cursor that INPUT advances.  The cursor is not reset
+ * by RUN or CLEAR: like standard input, each value is read once.
+ */
+
+class InputData {
+
+public:
+
+/*
+ * Constructor: InputData
+ * Usage: InputData data;
+ *        InputData data(values);
+ * ------------------------------
+ * Creates an empty data set, or one holding the given values, for
+ * clients that build their input in memory rather than from a file.
+ */
+
+    InputData() = default;
+    explicit InputData(std::vector<int> values) : values(std::move(values)) {}
+
+/*
+ * Method: load
+ * Usage: data.load(path);
+ * -----------------------
+ * Maps the file into memory and parses every value in it, replacing
+ * the previous contents.  Values are integers separated by any
+ * whitespace, so one per line and several per line both work.  A
+ * value is written as for INPUT: digits with an optional minus sign,
+ * within the range of int.  Calls error if the file cannot be read or
+ * holds anything else, naming the line of the bad value.
+ */
+
+    void load(const char *path);
+
+/*
+ * Method: loadSets
+ * Usage: std::vector<InputData> sets = InputData::loadSets(path);
+ * ---------------------------------------------------------------
+ * Reads a file of input sets for a batch run: each line that is not
+ * blank holds the values of one set, written as for load.
+ */
+
+    static std::vector<InputData> loadSets(const char *path);
+
+/*
+ * Method: next
+ * Usage: if (data.next(value)) ...
+ * --------------------------------
+ * Stores the next value in value and returns true, or returns false
+ * once every value has been read.
+ */
+
+    bool next(int &value) {
+        if (position == values.size()) return false;
+        value = values[position++];
+        return true;
+    }
+
+/*
+ * Method: remaining
+ * Usage: size_t count = data.remaining();
+ * ---------------------------------------
+ * Returns the number of values not read yet.
+ */
+
+    size_t remaining() const {
+        return values.size() - position;
+    }
+
+private:
+
+    std::vector<int> values;
+    size_t position = 0;
+
+};
+
+#endif
@@ -0,0 +1,363 @@
+/*
+ * File: jit.cpp
+ * -------------
+ * This file implements the JitCode class.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "jit.hpp"
+#include "output.hpp"
+
+#if defined(__x86_64__) && defined(__linux__)
+#define BASIC_JIT_X86_64
+#include <sys/mman.h>
+#endif
+
+#ifdef BASIC_JIT_X86_64
+
+/*
+ * Implementation notes: callbacks
+ * -------------------------------
+ * The generated code calls these functions for everything that touches
+ * the outside world.  They print exactly what the VM prints and never
+ * throw, because no unwind information is registered for the machine
+ * code.  INPUT can throw on bad input, which is why it is not compiled.
+ */
+
+static void jitPrint(int value) {
+    output().printInteger(value);
+}
+
+static void jitLineError() {
+    output().printLine("LINE NUMBER ERROR");
+}
+
+static void jitReport(int status) {
+    output().printLine(statusMessage(EvalStatus(status)));
+}
+
+static int jitCheck(RunLimiter *limiter, int lineNumber) {
+    return limiter->check(lineNumber);
+}
+
+namespace {
+
+/*
+ * Implementation notes: Assembler
+ * -------------------------------
+ * Just enough of an x86-64 encoder for the code below.  Register
+ * operands are eax, ecx or edx; memory operands are always
+ * [base + disp32] with base rbx, r12, r13 or r14, so only REX.B is
+ * ever needed.  Jumps are emitted with a rel32 placeholder that is patched
+ * once the target is known.
+ */
+
+enum Reg {
+    EAX = 0, ECX = 1, EDX = 2, RBX = 3, R12 = 12, R13 = 13, R14 = 14
+};
+
+enum Cond {
+    CC_E = 0x4, CC_NE = 0x5, CC_L = 0xc, CC_GE = 0xd, CC_LE = 0xe, CC_G = 0xf
+};
+
+class Assembler {
+
+public:
+
+    std::vector<uint8_t> bytes;
+
+    size_t offset() const {
+        return bytes.size();
+    }
+
+    void emit(std::initializer_list<int> list) {
+        for (int b: list) bytes.push_back(uint8_t(b));
+    }
+
+    void imm32(int32_t value) {
+        for (int i = 0; i < 4; i++) bytes.push_back(uint8_t(uint32_t(value) >> (8 * i)));
+    }
+
+    void imm64(uint64_t value) {
+        for (int i = 0; i < 8; i++) bytes.push_back(uint8_t(value >> (8 * i)));
+    }
+
+    // opcode reg, [base + disp]
+    void mem(std::initializer_list<int> opcode, int reg, Reg base, int32_t disp) {
+        if (base >= 8) emit({0x41});
+        emit(opcode);
+        emit({0x80 | (reg & 7) << 3 | (base & 7)});
+        if ((base & 7) == 4) emit({0x24});   //r12 作基址需要 SIB 字节
+        imm32(disp);
+    }
+
+    size_t jmp() {
+        emit({0xe9});
+        imm32(0);
+        return offset() - 4;
+    }
+
+    size_t jcc(Cond cond) {
+        emit({0x0f, 0x80 | cond});
+        imm32(0);
+        return offset() - 4;
+    }
+
+    void patch(size_t at, size_t target) {
+        int32_t rel = int32_t(int64_t(target) - int64_t(at + 4));
+        std::memcpy(&bytes[at], &rel, 4);
+    }
+
+    template <typename Function>
+    void call(Function *function) {
+        emit({0x48, 0xb8});                 //mov rax, imm64
+        imm64(reinterpret_cast<uintptr_t>(function));
+        emit({0xff, 0xd0});                 //call rax
+    }
+
+};
+
+}
+
+/*
+ * Implementation notes: translate
+ * -------------------------------
+ * The generated function has the signature
+ *
+ *     int f(int *values, unsigned char *defined, int *stack, RunLimiter *limiter);
+ *
+ * and keeps values in rbx, defined in r13, the operand stack in r12 and
+ * the limiter in r14.  Each line starts with an empty operand stack and
+ * the stack depth of every instruction is known statically, so stack
+ * entries are fixed offsets from r12 and no stack pointer is maintained
+ * at run time.  Four pushes and 8 more bytes in the prologue leave rsp
+ * 16-byte aligned for calls.
+ *
+ * OP_LINE decrements the countdown of the limiter in place and only
+ * calls out, through a stub after the epilogue, when it goes negative.
+ * The stub returns the status if check stops the program and otherwise
+ * resumes the line; nothing is live in registers at a line start.
+ *
+ * A failing instruction branches to a stub emitted after the epilogue.
+ * Which line the instruction belongs to is known when it is compiled,
+ * so the stub either prints the message and jumps to the next line (IF)
+ * or returns the status, the same decision the VM makes at run time.
+ */
+
+static bool translate(const Bytecode &bytecode, Assembler &as) {
+    const std::vector<int> &code = bytecode.code;
+    for (size_t pc = 0; pc < code.size(); pc += 2) {
+        if (code[pc] == OP_INPUT) return false;
+    }
+
+    struct Fixup {
+        size_t at;
+        int pc;         //目标指令；-1 表示 epilogue
+    };
+    struct ErrorExit {
+        size_t at;
+        int pc;         //出错的指令
+        EvalStatus status;
+    };
+    struct LimitExit {
+        size_t at;
+        size_t resume;  //检查通过后继续执行的位置
+        int lineNumber;
+    };
+    std::vector<size_t> native(code.size() / 2);
+    std::vector<Fixup> fixups;
+    std::vector<ErrorExit> errors;
+    std::vector<LimitExit> limits;
+
+    as.emit({0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56});   //push rbx; push r12; push r13; push r14
+    as.emit({0x48, 0x83, 0xec, 0x08});         //sub rsp, 8
+    as.emit({0x48, 0x89, 0xfb});               //mov rbx, rdi
+    as.emit({0x49, 0x89, 0xf5});               //mov r13, rsi
+    as.emit({0x49, 0x89, 0xd4});               //mov r12, rdx
+    as.emit({0x49, 0x89, 0xce});               //mov r14, rcx
+
+    size_t line = 0;
+    int depth = 0;
+    auto slot = [&](int index) { return int32_t(4 * index); };
+    for (int pc = 0; pc < int(code.size()); pc += 2) {
+        while (line < bytecode.lines.size() && bytecode.lines[line].pc == pc) {
+            depth = 0;
+            line++;
+        }
+        native[pc / 2] = as.offset();
+        int op = code[pc], arg = code[pc + 1];
+        switch (op) {
+            case OP_CONST:
+                as.mem({0xc7}, 0, R12, slot(depth++));          //mov dword [sp], imm32
+                as.imm32(arg);
+                break;
+            case OP_LOAD:
+                as.mem({0x80}, 7, R13, arg);                    //cmp byte [defined + v], 0
+                as.emit({0});
+                errors.push_back({as.jcc(CC_E), pc, EVAL_UNDEFINED_VARIABLE});
+                as.mem({0x8b}, EAX, RBX, slot(arg));            //mov eax, [values + v]
+                as.mem({0x89}, EAX, R12, slot(depth++));
+                break;
+            case OP_STORE:
+            case OP_ASSIGN:
+                if (op == OP_STORE) depth--;
+                as.mem({0x8b}, EAX, R12, slot(op == OP_STORE ? depth : depth - 1));
+                as.mem({0x89}, EAX, RBX, slot(arg));
+                as.mem({0xc6}, 0, R13, arg);                    //mov byte [defined + v], 1
+                as.emit({1});
+                break;
+            case OP_ADD:
+            case OP_SUB:
+            case OP_MUL:
+                depth--;
+                as.mem({0x8b}, EAX, R12, slot(depth - 1));
+                if (op == OP_ADD) as.mem({0x03}, EAX, R12, slot(depth));
+                else if (op == OP_SUB) as.mem({0x2b}, EAX, R12, slot(depth));
+                else as.mem({0x0f, 0xaf}, EAX, R12, slot(depth));
+                as.mem({0x89}, EAX, R12, slot(depth - 1));
+                break;
+            case OP_DIV:
+                depth--;
+                as.mem({0x8b}, ECX, R12, slot(depth));
+                as.emit({0x85, 0xc9});                          //test ecx, ecx
+                errors.push_back({as.jcc(CC_E), pc, EVAL_DIVIDE_BY_ZERO});
+                as.mem({0x8b}, EAX, R12, slot(depth - 1));
+                as.emit({0x99, 0xf7, 0xf9});                    //cdq; idiv ecx
+                as.mem({0x89}, EAX, R12, slot(depth - 1));
+                break;
+            case OP_FAIL:
+                errors.push_back({as.jmp(), pc, EvalStatus(arg)});
+                depth++;
+                break;
+            case OP_PRINT:
+                as.mem({0x8b}, 7, R12, slot(--depth));          //mov edi, [sp]
+                as.call(jitPrint);
+                break;
+            case OP_JUMP:
+                fixups.push_back({as.jmp(), arg});
+                break;
+            case OP_JUMP_EQ:
+            case OP_JUMP_LT:
+            case OP_JUMP_GT: {
+                depth -= 2;
+                as.mem({0x8b}, EAX, R12, slot(depth));
+                as.mem({0x3b}, EAX, R12, slot(depth + 1));      //cmp eax, [sp + 1]
+                Cond taken = op == OP_JUMP_EQ ? CC_E : op == OP_JUMP_LT ? CC_L : CC_G;
+                if (arg != NO_TARGET) {
+                    fixups.push_back({as.jcc(taken), arg});
+                    break;
+                }
+                size_t skip = as.jcc(Cond(taken ^ 1));          //条件不成立时跳过报错
+                as.call(jitLineError);
+                as.patch(skip, as.offset());
+                break;
+            }
+            case OP_LINE_ERROR:
+                as.call(jitLineError);
+                break;
+            case OP_LINE: {
+                as.mem({0x83}, 5, R14, int32_t(RunLimiter::countdownOffset()));   //sub dword [countdown], 1
+                as.emit({1});
+                size_t at = as.jcc(CC_L);
+                limits.push_back({at, as.offset(), arg});
+                break;
+            }
+            case OP_HALT:
+            default:
+                as.emit({0x31, 0xc0});                          //xor eax, eax
+                fixups.push_back({as.jmp(), -1});
+                break;
+        }
+    }
+
+    size_t epilogue = as.offset();
+    as.emit({0x48, 0x83, 0xc4, 0x08});                          //add rsp, 8
+    as.emit({0x41, 0x5e, 0x41, 0x5d, 0x41, 0x5c, 0x5b, 0xc3});  //pop r14; pop r13; pop r12; pop rbx; ret
+    for (const Fixup &fixup: fixups) {
+        as.patch(fixup.at, fixup.pc < 0 ? epilogue : native[fixup.pc / 2]);
+    }
+    for (const ErrorExit &error: errors) {
+        as.patch(error.at, as.offset());
+        const LineInfo *info = bytecode.findLine(error.pc);
+        if (info != nullptr && info->type == IF_STMT) {
+            as.emit({0xbf});                                    //mov edi, status
+            as.imm32(error.status);
+            as.call(jitReport);
+            as.patch(as.jmp(), native[bytecode.nextLinePc(info) / 2]);
+        } else {
+            as.emit({0xb8});                                    //mov eax, status
+            as.imm32(error.status);
+            as.patch(as.jmp(), epilogue);
+        }
+    }
+    for (const LimitExit &exit: limits) {
+        as.patch(exit.at, as.offset());
+        as.emit({0x4c, 0x89, 0xf7});                            //mov rdi, r14
+        as.emit({0xbe});                                        //mov esi, lineNumber
+        as.imm32(exit.lineNumber);
+        as.call(jitCheck);
+        as.emit({0x85, 0xc0});                                  //test eax, eax
+        as.patch(as.jcc(CC_NE), epilogue);                      //超出限制：eax 就是返回的状态
+        as.patch(as.jmp(), exit.resume);
+    }
+    return true;
+}
+
+/*
+ * Implementation notes: compile
+ * -----------------------------
+ * The code is assembled into a vector, copied into a fresh mapping and
+ * the mapping is then made read-only and executable, so no page is
+ * ever writable and executable at the same time.
+ */
+
+JitCode *JitCode::compile(const Bytecode &bytecode) {
+    Assembler as;
+    if (!translate(bytecode, as)) return nullptr;
+    size_t size = as.bytes.size();
+    void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return nullptr;
+    std::memcpy(memory, as.bytes.data(), size);
+    if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, size);
+        return nullptr;
+    }
+    return new JitCode(memory, size, bytecode.maxStack);
+}
+
+JitCode::~JitCode() {
+    munmap(memory, size);
+}
+
+EvalStatus JitCode::run(EvalState &state, RunLimiter *limiter) const {
+    using Entry = int (*)(int *, unsigned char *, int *, RunLimiter *);
+    std::vector<int> stack(maxStack + 1);
+    auto entry = reinterpret_cast<Entry>(memory);
+    return EvalStatus(entry(state.valueArray(), state.definedArray(), stack.data(), limiter));
+}
+
+bool JitCode::available() {
+    return true;
+}
+
+#else
+
+JitCode *JitCode::compile(const Bytecode &) {
+    return nullptr;
+}
+
+JitCode::~JitCode() = default;
+
+EvalStatus JitCode::run(EvalState &, RunLimiter *) const {
+    return EVAL_OK;
+}
+
+bool JitCode::available() {
+    return false;
+}
+
+#endif
+
+JitCode::JitCode(void *memory, size_t size, int maxStack) : memory(memory), size(size), maxStack(maxStack) {}
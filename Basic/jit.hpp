@@ -0,0 +1,79 @@
+/*
+ * File: jit.h
+ * -----------
+ * This interface exports the JitCode class, a native-code back end for
+ * the bytecode produced by BytecodeCompiler.  On x86-64 Linux a program
+ * that only uses LET, IF, GOTO, PRINT, REM and END is translated into
+ * machine code in an executable buffer; every other program, and every
+ * program on other platforms, keeps running in the VirtualMachine.
+ */
+
+#ifndef _jit_h
+#define _jit_h
+
+#include <cstddef>
+#include "bytecode.hpp"
+#include "evalstate.hpp"
+
+/*
+ * Class: JitCode
+ * --------------
+ * The machine code for one Bytecode object.  It reads and writes the
+ * variable slots of an EvalState directly and calls back into the
+ * interpreter to print values and error messages, so its output and
+ * its error behaviour are the same as those of the VM.
+ */
+
+class JitCode {
+
+public:
+
+/*
+ * Method: compile
+ * Usage: JitCode *jit = JitCode::compile(bytecode);
+ * -------------------------------------------------
+ * Returns newly allocated machine code for the bytecode, or nullptr if
+ * the bytecode uses an instruction the JIT does not translate (INPUT)
+ * or the platform is not supported.  The caller owns the result.
+ */
+
+    static JitCode *compile(const Bytecode &bytecode);
+
+    ~JitCode();
+
+    JitCode(const JitCode &) = delete;
+
+    JitCode &operator=(const JitCode &) = delete;
+
+/*
+ * Method: run
+ * Usage: EvalStatus status = jit->run(state);
+ *        EvalStatus status = jit->run(state, &limiter);
+ * -----------------------------------------------------
+ * Executes the program like VirtualMachine::run, with the limiter that
+ * bytecode compiled with countSteps needs.  state must have at least
+ * the slots that were interned when the bytecode was compiled.
+ */
+
+    EvalStatus run(EvalState &state, RunLimiter *limiter = nullptr) const;
+
+/*
+ * Method: available
+ * Usage: if (JitCode::available()) . . .
+ * ---------------------------------------
+ * Returns true if this build can generate native code.
+ */
+
+    static bool available();
+
+private:
+
+    JitCode(void *memory, size_t size, int maxStack);
+
+    void *memory;       //mmap 出来的可执行内存
+    size_t size;
+    int maxStack;
+
+};
+
+#endif
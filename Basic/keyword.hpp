@@ -0,0 +1,111 @@
+/*
+ * File: keyword.h
+ * ---------------
+ * This interface exports the Keyword type and a constexpr classifier
+ * that maps a word to its keyword.  processLine uses it to dispatch
+ * commands and IsLegalWord uses it to reject reserved variable names.
+ */
+
+#ifndef _keyword_h
+#define _keyword_h
+
+#include <string_view>
+
+/*
+ * Type: Keyword
+ * -------------
+ * The words with a special meaning in BASIC.  KW_NONE is returned for
+ * every other word.
+ */
+
+enum Keyword {
+    KW_NONE, KW_REM, KW_LET, KW_PRINT, KW_INPUT, KW_END, KW_GOTO,
+    KW_IF, KW_THEN, KW_RUN, KW_LIST, KW_CLEAR, KW_QUIT, KW_HELP,
+    KW_COMPILE, KW_PROFILE, KW_LIMIT
+};
+
+/*
+ * Function: classifyKeyword
+ * Usage: Keyword kw = classifyKeyword(word);
+ * ------------------------------------------
+ * Returns the keyword spelled by word, or KW_NONE.  Keywords are
+ * uppercase and case sensitive.
+ */
+
+/*
+ * Implementation notes: classifyKeyword
+ * -------------------------------------
+ * The keywords are distinguished by their length and first character
+ * (REM and RUN also by the second), so the switches leave a single
+ * candidate to compare against.
+ */
+
+constexpr Keyword classifyKeyword(std::string_view word) {
+    Keyword candidate = KW_NONE;
+    std::string_view spelling;
+    if (word.empty()) return KW_NONE;
+    switch (word.length()) {
+        case 2:
+            if (word[0] == 'I') candidate = KW_IF, spelling = "IF";
+            break;
+        case 3:
+            switch (word[0]) {
+                case 'R':
+                    if (word[1] == 'E') candidate = KW_REM, spelling = "REM";
+                    else candidate = KW_RUN, spelling = "RUN";
+                    break;
+                case 'L': candidate = KW_LET, spelling = "LET"; break;
+                case 'E': candidate = KW_END, spelling = "END"; break;
+            }
+            break;
+        case 4:
+            switch (word[0]) {
+                case 'G': candidate = KW_GOTO, spelling = "GOTO"; break;
+                case 'T': candidate = KW_THEN, spelling = "THEN"; break;
+                case 'L': candidate = KW_LIST, spelling = "LIST"; break;
+                case 'Q': candidate = KW_QUIT, spelling = "QUIT"; break;
+                case 'H': candidate = KW_HELP, spelling = "HELP"; break;
+            }
+            break;
+        case 5:
+            switch (word[0]) {
+                case 'P': candidate = KW_PRINT, spelling = "PRINT"; break;
+                case 'I': candidate = KW_INPUT, spelling = "INPUT"; break;
+                case 'C': candidate = KW_CLEAR, spelling = "CLEAR"; break;
+                case 'L': candidate = KW_LIMIT, spelling = "LIMIT"; break;
+            }
+            break;
+        case 7:
+            switch (word[0]) {
+                case 'C': candidate = KW_COMPILE, spelling = "COMPILE"; break;
+                case 'P': candidate = KW_PROFILE, spelling = "PROFILE"; break;
+            }
+            break;
+    }
+    return candidate != KW_NONE && word == spelling ? candidate : KW_NONE;
+}
+
+/*
+ * Function: isReservedWord
+ * Usage: if (isReservedWord(kw)) ...
+ * ----------------------------------
+ * Returns true if the keyword may not be used as a variable name.
+ * INPUT has never been reserved, so programs may still use it; nor are
+ * the commands from KW_COMPILE on, which came later than the programs
+ * that might use the names.
+ */
+
+constexpr bool isReservedWord(Keyword kw) {
+    return kw != KW_NONE && kw != KW_INPUT && kw < KW_COMPILE;
+}
+
+static_assert(classifyKeyword("REM") == KW_REM && classifyKeyword("RUN") == KW_RUN);
+static_assert(classifyKeyword("PRINT") == KW_PRINT && classifyKeyword("INPUT") == KW_INPUT);
+static_assert(classifyKeyword("THEN") == KW_THEN && classifyKeyword("HELP") == KW_HELP);
+static_assert(classifyKeyword("COMPILE") == KW_COMPILE && !isReservedWord(KW_COMPILE));
+static_assert(classifyKeyword("PROFILE") == KW_PROFILE && !isReservedWord(KW_PROFILE));
+static_assert(classifyKeyword("LIMIT") == KW_LIMIT && !isReservedWord(KW_LIMIT) && isReservedWord(KW_CLEAR));
+static_assert(classifyKeyword("RUM") == KW_NONE && classifyKeyword("if") == KW_NONE);
+static_assert(classifyKeyword("") == KW_NONE && classifyKeyword("X") == KW_NONE);
+
+#endif
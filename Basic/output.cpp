@@ -0,0 +1,138 @@
+/*
+ * File: output.cpp
+ * ----------------
+ * This file implements the OutputBuffer class.
+ */
+
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+#include <unistd.h>
+#include "output.hpp"
+
+/*
+ * Implementation notes: formatInteger
+ * -----------------------------------
+ * The number of digits is found first, then the digits are written
+ * from the right two at a time out of a table of the pairs 00 to 99,
+ * which halves the number of divisions.  The magnitude is computed in
+ * unsigned arithmetic so that INT_MIN needs no special case.
+ */
+
+static const char DIGIT_PAIRS[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+static const unsigned POWERS_OF_TEN[] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+char *OutputBuffer::formatInteger(int value, char *out) {
+    unsigned magnitude = unsigned(value);
+    if (value < 0) {
+        *out++ = '-';
+        magnitude = 0u - magnitude;
+    }
+    int length = 1;
+    while (length < 10 && magnitude >= POWERS_OF_TEN[length]) length++;
+    char *end = out + length;
+    char *digit = end;
+    while (magnitude >= 100) {
+        unsigned pair = magnitude % 100 * 2;
+        magnitude /= 100;
+        *--digit = DIGIT_PAIRS[pair + 1];
+        *--digit = DIGIT_PAIRS[pair];
+    }
+    if (magnitude >= 10) {
+        *--digit = DIGIT_PAIRS[magnitude * 2 + 1];
+        *--digit = DIGIT_PAIRS[magnitude * 2];
+    } else {
+        *--digit = char('0' + magnitude);
+    }
+    return end;
+}
+
+/*
+ * Implementation notes: OutputBuffer
+ * ----------------------------------
+ * The standard instance is never destroyed: std::cout still points at it while
+ * the standard streams are flushed at exit, after every atexit handler
+ * has run.  The handler registered here makes sure the buffer reaches
+ * the file even if that flush were skipped.
+ */
+
+static thread_local OutputBuffer *currentOutput = nullptr;   //OutputScope 设置的缓冲区
+
+OutputBuffer::OutputBuffer() {
+    setp(buffer, buffer + BUFFER_SIZE);
+    std::cout.rdbuf(this);
+    std::atexit([] { standard().flush(); });
+}
+
+OutputBuffer::OutputBuffer(std::string &text) : text(&text) {
+    setp(buffer, buffer + BUFFER_SIZE);
+}
+
+OutputBuffer &OutputBuffer::standard() {
+    static OutputBuffer *instance = new OutputBuffer();
+    return *instance;
+}
+
+OutputBuffer &output() {
+    if (currentOutput != nullptr) return *currentOutput;
+    return OutputBuffer::standard();
+}
+
+OutputScope::OutputScope(OutputBuffer &buffer) : previous(currentOutput) {
+    currentOutput = &buffer;
+}
+
+OutputScope::~OutputScope() {
+    currentOutput->flush();
+    currentOutput = previous;
+}
+
+static void writeAll(const char *data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(STDOUT_FILENO, data, size);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return;   //写不出去（如管道已关闭）就丢弃，与 cout 出错后的行为一致
+        data += written;
+        size -= written;
+    }
+}
+
+void OutputBuffer::flush() {
+    if (text != nullptr) text->append(pbase(), pptr());
+    else writeAll(pbase(), pptr() - pbase());
+    setp(buffer, buffer + BUFFER_SIZE);
+}
+
+OutputBuffer::int_type OutputBuffer::overflow(int_type c) {
+    flush();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+std::streamsize OutputBuffer::xsputn(const char *data, std::streamsize count) {
+    if (count > epptr() - pptr()) {
+        flush();
+        if (count >= std::streamsize(BUFFER_SIZE)) {   //比缓冲区还大：直接写出
+            if (this->text != nullptr) this->text->append(data, count);
+            else writeAll(data, count);
+            return count;
+        }
+    }
+    std::memcpy(pptr(), data, count);
+    pbump(int(count));
+    return count;
+}
+
+int OutputBuffer::sync() {
+    flush();
+    return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * File: output.h
+ * --------------
+ * This interface exports the OutputBuffer class, the buffered standard
+ * output of the interpreter.  PRINT formats its integers straight into
+ * a large user-space buffer that is written to file descriptor 1 only
+ * when it fills up or is flushed.  The buffer is also installed as the
+ * stream buffer of std::cout, so everything else the interpreter prints
+ * lands in the same buffer, in order.  A thread can redirect output()
+ * into a buffer of its own that collects the text in memory, which is
+ * how parallel runs keep their outputs apart.
+ */
+
+#ifndef _output_h
+#define _output_h
+
+#include <cstring>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+/*
+ * Class: OutputBuffer
+ * -------------------
+ * A std::streambuf over a fixed buffer with fast paths for the output
+ * of RUN.  The instance that writes to standard output is created by
+ * the first call to output().  The buffer is flushed:
+ *
+ *   whenever std::cout is flushed, so std::endl and std::flush work
+ *   before std::cin reads a line, since std::cin is tied to std::cout
+ *   before std::cerr writes, since std::cerr is tied to std::cout too
+ *   at exit, including exit() from END and QUIT
+ */
+
+class OutputBuffer : public std::streambuf {
+
+public:
+
+    static const size_t BUFFER_SIZE = 1 << 16;
+
+/*
+ * Constructor: OutputBuffer
+ * Usage: OutputBuffer buffer(text);
+ * ---------------------------------
+ * Creates a buffer whose flushes append to text instead of writing to
+ * standard output.  It is used through an OutputScope.
+ */
+
+    explicit OutputBuffer(std::string &text);
+
+    OutputBuffer(const OutputBuffer &) = delete;
+
+    OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+/*
+ * Method: printInteger
+ * Usage: output().printInteger(value);
+ * ------------------------------------
+ * Writes value in decimal followed by a newline, as PRINT does.
+ */
+
+    void printInteger(int value) {
+        if (epptr() - pptr() < MAX_INTEGER_LINE) flush();
+        char *end = formatInteger(value, pptr());
+        *end++ = '\n';
+        pbump(int(end - pptr()));
+    }
+
+/*
+ * Methods: printText, printLine
+ * Usage: output().printLine("LINE NUMBER ERROR");
+ * -----------------------------------------------
+ * Writes text, followed by a newline in the case of printLine.
+ */
+
+    void printText(std::string_view text) {
+        if (size_t(epptr() - pptr()) < text.size()) {
+            sputn(text.data(), std::streamsize(text.size()));
+            return;
+        }
+        std::memcpy(pptr(), text.data(), text.size());
+        pbump(int(text.size()));
+    }
+
+    void printLine(std::string_view text) {
+        printText(text);
+        sputc('\n');
+    }
+
+/*
+ * Method: flush
+ * Usage: output().flush();
+ * ------------------------
+ * Writes everything buffered so far to standard output.
+ */
+
+    void flush();
+
+/*
+ * Function: formatInteger
+ * Usage: char *end = OutputBuffer::formatInteger(value, out);
+ * -----------------------------------------------------------
+ * Writes the decimal form of value at out, without a terminator, and
+ * returns the position after the last digit.  out must have room for
+ * 11 characters.
+ */
+
+    static char *formatInteger(int value, char *out);
+
+protected:
+
+    int_type overflow(int_type c) override;
+
+    std::streamsize xsputn(const char *data, std::streamsize count) override;
+
+    int sync() override;
+
+private:
+
+    static const int MAX_INTEGER_LINE = 12;   //"-2147483648\n"
+
+    char buffer[BUFFER_SIZE];
+    std::string *text = nullptr;   //不为 nullptr 时输出收集到这里，而不写到标准输出
+
+    OutputBuffer();
+
+    static OutputBuffer &standard();
+
+    friend OutputBuffer &output();
+
+};
+
+/*
+ * Function: output
+ * Usage: output().printInteger(value);
+ * ------------------------------------
+ * Returns the buffer of the innermost OutputScope on this thread, or
+ * else the standard output buffer, which is installed under std::cout
+ * the first time it is needed.  main calls output() before printing
+ * anything, so that no output goes through the previous stream buffer.
+ */
+
+OutputBuffer &output();
+
+/*
+ * Class: OutputScope
+ * ------------------
+ * While an OutputScope is alive, output() on the same thread returns
+ * its buffer.  Scopes nest; the destructor flushes the buffer and
+ * restores the previous one.  Text written with std::cout is not
+ * redirected.
+ */
+
+class OutputScope {
+
+public:
+
+    explicit OutputScope(OutputBuffer &buffer);
+
+    ~OutputScope();
+
+private:
+
+    OutputBuffer *previous;
+
+};
+
+#endif
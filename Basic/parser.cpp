@@ -11,17 +11,25 @@
 /*
  * Implementation notes: parseExp
  * ------------------------------
- * This code just reads an expression and then checks for extra tokens.
+ * This code just reads an expression, checks for extra tokens and
+ * then simplifies the tree.
  */
 
+static bool constantFolding = true;
+
 Expression *parseExp(TokenScanner &scanner) {
     Expression *exp = readE(scanner);
     if (scanner.hasMoreTokens()) {
         error("parseExp: Found extra token: " + scanner.nextToken());
     }
+    if (constantFolding) exp = exp->simplify();
     return exp;
 }
 
+void setConstantFolding(bool flag) {
+    constantFolding = flag;
+}
+
 /*
  * Implementation notes: readE
  * Usage: exp = readE(scanner, prec);
@@ -35,13 +43,14 @@ Expression *parseExp(TokenScanner &scanner) {
 
 Expression *readE(TokenScanner &scanner, int prec) {
     Expression *exp = readT(scanner);
-    std::string token;
+    Token token;
     while (true) {
-        token = scanner.nextToken();
-        int newPrec = precedence(token);
+        token = scanner.nextTokenView();
+        int newPrec = precedence(token.text);
         if (newPrec <= prec) break;
+        std::string op(token.text);   //递归读取右侧时 token 可能失效，先保存运算符
         Expression *rhs = readE(scanner, newPrec);
-        exp = new CompoundExp(token, exp, rhs);
+        exp = makeCompoundExp(op, exp, rhs);
     }
     scanner.saveToken(token);
     return exp;
@@ -54,24 +63,21 @@ Expression *readE(TokenScanner &scanner, int prec) {
  * or a parenthesized subexpression.
  */
 Expression *readT(TokenScanner &scanner) {
-    std::string token = scanner.nextToken();
-    TokenType type = scanner.getTokenType(token);
-    if (type == WORD) return new IdentifierExp(token);
-    else if (type == NUMBER) return new ConstantExp(stringToInteger(token));
-    else if (type == OPERATOR) {
-        if (token == "-") {
-            token = scanner.nextToken();
-            type = scanner.getTokenType(token);
-            if (type != NUMBER)error("Illegal term in expression");
-            return new ConstantExp((-1)*stringToInteger(token));
-        } else if (token == "+") {
-            token = scanner.nextToken();
-            type = scanner.getTokenType(token);
-            if (type != NUMBER) error("Illegal term in expression");
-            return new ConstantExp(stringToInteger(token));
-        } else if (token == "(") {
+    Token token = scanner.nextTokenView();
+    if (token.type == WORD) return new IdentifierExp(std::string(token.text));
+    else if (token.type == NUMBER) return new ConstantExp(stringToInteger(token.text));
+    else if (token.type == OPERATOR) {
+        if (token.text == "-") {
+            token = scanner.nextTokenView();
+            if (token.type != NUMBER)error("Illegal term in expression");
+            return new ConstantExp((-1)*stringToInteger(token.text));
+        } else if (token.text == "+") {
+            token = scanner.nextTokenView();
+            if (token.type != NUMBER) error("Illegal term in expression");
+            return new ConstantExp(stringToInteger(token.text));
+        } else if (token.text == "(") {
             Expression *exp = readE(scanner);
-            if (scanner.nextToken() != ")") error("Unbalanced parentheses in expression");
+            if (scanner.nextTokenView().text != ")") error("Unbalanced parentheses in expression");
             return exp;
         } else {
             error("Illegal term in expression");
@@ -82,6 +88,26 @@ Expression *readT(TokenScanner &scanner) {
     return nullptr;
 }
 
+/*
+ * Implementation notes: makeCompoundExp, makeComparisonExp
+ * --------------------------------------------------------
+ * The operator token is inspected once, here, to choose the node class.
+ */
+
+CompoundExp *makeCompoundExp(std::string_view op, Expression *lhs, Expression *rhs) {
+    if (op == "=") return new AssignExp(lhs, rhs);
+    if (op == "+") return new AddExp(lhs, rhs);
+    if (op == "-") return new SubExp(lhs, rhs);
+    if (op == "*") return new MulExp(lhs, rhs);
+    return new DivExp(lhs, rhs);
+}
+
+CompoundExp *makeComparisonExp(std::string_view op, Expression *lhs, Expression *rhs) {
+    if (op == "=") return new EqualExp(lhs, rhs);
+    if (op == "<") return new LessExp(lhs, rhs);
+    return new GreaterExp(lhs, rhs);
+}
+
 /*
  * Implementation notes: precedence
  * --------------------------------
@@ -89,7 +115,7 @@ Expression *readT(TokenScanner &scanner) {
  * and returns the appropriate precedence value.
  */
 
-int precedence(std::string token) {
+int precedence(std::string_view token) {
     if (token == "=") return 1;
     if (token == "+" || token == "-") return 2;
     if (token == "*" || token == "/") return 3;
@@ -22,11 +22,22 @@
  * -------------------------------------------
  * Parses an expression by reading tokens from the scanner, which must
  * be provided by the client.  The scanner should be set to ignore
- * whitespace and to scan numbers.
+ * whitespace and to scan numbers.  Unless constant folding has been
+ * turned off, the result has been passed through simplify.
  */
 
 Expression *parseExp(TokenScanner &scanner);
 
+/*
+ * Function: setConstantFolding
+ * Usage: setConstantFolding(false);
+ * ---------------------------------
+ * Turns the simplify pass of parseExp on or off.  It is on by default;
+ * turning it off lets the output be compared with the unoptimized trees.
+ */
+
+void setConstantFolding(bool flag);
+
 /*
  * Function: readE
  * Usage: Expression *exp = readE(scanner, prec);
@@ -48,6 +59,26 @@ Expression *readE(TokenScanner &scanner, int prec = 0);
 
 Expression *readT(TokenScanner &scanner);
 
+/*
+ * Function: makeCompoundExp
+ * Usage: Expression *exp = makeCompoundExp(op, lhs, rhs);
+ * -------------------------------------------------------
+ * Returns a new node of the CompoundExp subclass that implements the
+ * operator token op, which must be one of "=", "+", "-", "*" or "/".
+ */
+
+CompoundExp *makeCompoundExp(std::string_view op, Expression *lhs, Expression *rhs);
+
+/*
+ * Function: makeComparisonExp
+ * Usage: CompoundExp *cond = makeComparisonExp(op, lhs, rhs);
+ * -----------------------------------------------------------
+ * Returns a new comparison node for the relation op of an IF statement,
+ * which must be one of "=", "<" or ">".
+ */
+
+CompoundExp *makeComparisonExp(std::string_view op, Expression *lhs, Expression *rhs);
+
 /*
  * Function: precedence
  * Usage: int prec = precedence(token);
@@ -56,6 +87,6 @@ Expression *readT(TokenScanner &scanner);
  * is not an operator, precedence returns 0.
  */
 
-int precedence(std::string token);
+int precedence(std::string_view token);
 
 #endif
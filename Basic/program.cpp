@@ -8,22 +8,42 @@
  * the performance guarantees specified in the assignment.
  */
 
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <iomanip>
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#else
+#include <ctime>
+#endif
 #include "program.hpp"
+#include "bytecode.hpp"
+#include "vm.hpp"
+#include "jit.hpp"
 
 
 
 Program::Program() = default;  //希望仍然保留编译器的默认构造行为
 
-Program::~Program() = default;
+Program::~Program() {
+    clear();
+    delete bytecode;
+    delete jit;
+}
 
 void Program::clear() {
     for(auto it=program_map.begin();it!=program_map.end();it++){
         delete it->second.stmt;
     }
-    program_map.clear();
+    program_map.clear();   //每行的 LineArena 把 chunk 还给 arena
+    arena.release();       //再整体释放所有 slab
+    profile.clear();
+    invalidate();
 }
 
 void Program::addSourceLine(int lineNumber, const std::string &line) {
+    invalidate();
     node a;
     a.source_line=line;
     auto it=program_map.find(lineNumber);
@@ -32,12 +52,35 @@ void Program::addSourceLine(int lineNumber, const std::string &line) {
         it->second.stmt= nullptr;
         program_map.erase(it);
     }
-    program_map.insert(std::pair<int,node>(lineNumber,a));
+    program_map.insert(std::pair<int,node>(lineNumber,std::move(a)));
+}
+
+/*
+ * Implementation notes: addParsedLine
+ * -----------------------------------
+ * If the new line number is past the last one, end() is the exact
+ * insertion hint and emplace_hint appends in constant time.  An
+ * existing line is updated in place.
+ */
+
+void Program::addParsedLine(int lineNumber, std::string_view line, Statement *stmt, LineArena arena) {
+    invalidate();
+    auto it=program_map.end();
+    if(!program_map.empty() && program_map.rbegin()->first>=lineNumber) it=program_map.lower_bound(lineNumber);
+    if(it!=program_map.end() && it->first==lineNumber){
+        delete it->second.stmt;
+        it->second.source_line.assign(line);
+        it->second.stmt=stmt;
+        it->second.arena=std::move(arena);   //旧的 chunk 回到 arena 的空闲链表
+        return;
+    }
+    program_map.emplace_hint(it,lineNumber,node{std::string(line),stmt,std::move(arena)});
 }
 
 void Program::removeSourceLine(int lineNumber) {
     auto it=program_map.find(lineNumber);
     if(it==program_map.end()) return; //没有找到这个行号，直接返回
+    invalidate();
     delete it->second.stmt;
     it->second.stmt= nullptr;
     program_map.erase(it);
@@ -55,6 +98,7 @@ void Program::setParsedStatement(int lineNumber, Statement *stmt) {
         error("SYNTAX ERROR");
         return;
     }
+    invalidate();
     delete it->second.stmt;
     it->second.stmt=stmt;
 }
@@ -76,13 +120,312 @@ int Program::getNextLineNumber(int lineNumber) {
     return it->first;
 }
 
-void Program::execute_all(EvalState & state) {
-    auto it=program_map.begin();
-    while(it!=program_map.end()){
-        auto temp=it;
-        it->second.stmt->execute(state,*this,it);  //观察有无跳转，如果已经发生跳转，就不再进行自增运算。
-        if(it==temp) it++;
+EvalStatus Program::execute_all(EvalState & state) {
+    //每次 RUN 只判断一次，不开启时没有额外开销
+    if(profiling){
+        if(!linked) link();
+        bool limited=step_limit!=0 || time_limit_ms!=0;
+        return limited ? execute_instrumented<true,true>(state,last_run,profile)
+                       : execute_instrumented<true,false>(state,last_run,profile);
+    }
+    prepare();
+    return run(state,last_run);
+}
+
+void Program::prepare() {
+    if(use_bytecode){
+        bool limited=step_limit!=0 || time_limit_ms!=0;
+        if(bytecode==nullptr) bytecode=BytecodeCompiler().compile(*this,limited);   //有限制时每行开头计数
+        if(use_jit && !jit_tried){
+            jit=JitCode::compile(*bytecode);   //含 INPUT 等不支持的语句时返回 nullptr
+            jit_tried=true;
+        }
+    }else if(!linked){
+        link();
+    }
+}
+
+/*
+ * Implementation notes: run
+ * -------------------------
+ * Everything run reads was built by prepare and is only replaced by an
+ * edit of the program, so concurrent runs share it without locking.
+ * The profile is the one piece of per-run data kept in the Program,
+ * which is why profiled RUNs go through execute_all alone.
+ */
+
+EvalStatus Program::run(EvalState & state, RunStats & stats) const {
+    bool limited=step_limit!=0 || time_limit_ms!=0;
+    if(use_bytecode && limited){
+        RunLimiter limiter(step_limit,time_limit_ms);
+        EvalStatus status=(use_jit && jit!=nullptr) ? jit->run(state,&limiter)
+                                                   : VirtualMachine().run(*bytecode,state,&limiter);
+        limiter.finish(stats);
+        return status;
+    }
+    if(use_bytecode){
+        if(use_jit && jit!=nullptr) return jit->run(state);
+        return VirtualMachine().run(*bytecode,state);
+    }
+    if(limited){
+        std::vector<LineProfile> unused;
+        return execute_instrumented<false,true>(state,stats,unused);
+    }
+    const int count=int(exec_lines.size());
+    int pc=0;
+    while(pc<count){
+        const Statement *stmt=exec_lines[pc].stmt;
+        pc++;   //顺序执行只是下标加一，跳转语句会改写 pc
+        EvalStatus status=stmt->execute(state,pc);
+        if(status!=EVAL_OK) return status;
+    }
+    return EVAL_OK;
+}
+
+/*
+ * Implementation notes: execute_instrumented
+ * ------------------------------------------
+ * A copy of the tree interpreter loop for the profiler, and for the
+ * limits when RUN uses the tree interpreter, instantiated for the
+ * combinations in use, so neither costs anything when it is off.
+ *
+ * Execution counts are exact.  Reading the tick counter around every
+ * statement would cost more than most statements (rdtsc alone is
+ * 10-40ns, more under virtualization), so time is sampled: one
+ * statement in SAMPLE_PERIOD on average, at pseudo-random intervals so
+ * that no loop can line up with the sampling, is timed and charged
+ * SAMPLE_PERIOD times its ticks.  The cost of the reading itself is
+ * measured once per RUN and subtracted.
+ *
+ * The step limit is one comparison per statement.  The clock is read
+ * only every CLOCK_INTERVAL statements, so a time limit is noticed at
+ * most that many statements late.
+ */
+
+static const unsigned SAMPLE_PERIOD = 32;
+static const unsigned CLOCK_INTERVAL = 1024;
+
+static inline uint64_t readTicks() {
+#if defined(__x86_64__)
+    return __rdtsc();
+#else
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return uint64_t(now.tv_sec) * 1000000000u + uint64_t(now.tv_nsec);
+#endif
+}
+
+static uint64_t readOverhead() {
+    uint64_t best=UINT64_MAX;
+    for(int i=0;i<32;i++){
+        uint64_t start=readTicks();
+        best=std::min(best,readTicks()-start);
+    }
+    return best;
+}
+
+static inline unsigned nextInterval(uint32_t &seed) {
+    seed^=seed<<13;   //xorshift32
+    seed^=seed>>17;
+    seed^=seed<<5;
+    return 1+seed%(2*SAMPLE_PERIOD-1);   //1 .. 2*SAMPLE_PERIOD-1，平均为 SAMPLE_PERIOD
+}
+
+static long millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return long(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now()-start).count());
+}
+
+/*
+ * Implementation notes: RunLimiter
+ * --------------------------------
+ * check is reached with every statement of the previous batch started,
+ * so steps then counts exactly the statements the tree loop would have
+ * executed, and the tests are the ones it makes, in the same order.
+ * A batch is CLOCK_INTERVAL statements, or what is left of the step
+ * limit if that is less.  The statement that called check is already
+ * counted in the new batch.
+ */
+
+RunLimiter::RunLimiter(long stepLimit, long timeLimit)
+        : stepLimit(stepLimit), timeLimit(timeLimit), started(std::chrono::steady_clock::now()) {}
+
+EvalStatus RunLimiter::check(int lineNumber) {
+    steps+=granted;
+    granted=0;
+    countdown=0;
+    EvalStatus status=EVAL_OK;
+    if(stepLimit!=0 && steps==stepLimit) status=EVAL_STEP_LIMIT;
+    else if(timeLimit!=0 && millisecondsSince(started)>=timeLimit) status=EVAL_TIME_LIMIT;
+    if(status!=EVAL_OK){
+        stoppedAt=lineNumber;
+        return status;
+    }
+    long batch=CLOCK_INTERVAL;
+    if(stepLimit!=0) batch=std::min(batch,stepLimit-steps);
+    granted=int(batch);
+    countdown=granted-1;
+    return EVAL_OK;
+}
+
+void RunLimiter::finish(RunStats &stats) const {
+    stats.steps=steps+granted-countdown;
+    stats.milliseconds=millisecondsSince(started);
+    stats.lineNumber=stoppedAt;
+}
+
+size_t RunLimiter::countdownOffset() {
+    return offsetof(RunLimiter,countdown);
+}
+
+template <bool PROFILE, bool LIMIT>
+EvalStatus Program::execute_instrumented(EvalState & state, RunStats & stats, std::vector<LineProfile> & line_profile) const {
+    const int count=int(exec_lines.size());
+    if(PROFILE){
+        line_profile.clear();
+        line_profile.reserve(count);
+        for(const ExecLine &line: exec_lines) line_profile.push_back({line.lineNumber,0,0});
+    }
+    const uint64_t overhead=PROFILE ? readOverhead() : 0;
+    uint32_t seed=2463534242u;
+    unsigned countdown=nextInterval(seed);
+    auto started=std::chrono::steady_clock::now();
+    unsigned until_clock=CLOCK_INTERVAL;
+    long steps=0;
+    EvalStatus status=EVAL_OK;
+    int pc=0;
+    while(pc<count){
+        int current=pc;
+        if(LIMIT){
+            if(steps==step_limit && step_limit!=0){
+                status=EVAL_STEP_LIMIT;
+                break;
+            }
+            if(--until_clock==0){
+                until_clock=CLOCK_INTERVAL;
+                if(time_limit_ms!=0 && millisecondsSince(started)>=time_limit_ms){
+                    status=EVAL_TIME_LIMIT;
+                    break;
+                }
+            }
+        }
+        steps++;
+        pc++;
+        if(!PROFILE){
+            status=exec_lines[current].stmt->execute(state,pc);
+        }else if(line_profile[current].count++, --countdown!=0){
+            status=exec_lines[current].stmt->execute(state,pc);
+        }else{
+            uint64_t start=readTicks();
+            status=exec_lines[current].stmt->execute(state,pc);
+            uint64_t elapsed=readTicks()-start;
+            line_profile[current].ticks+=SAMPLE_PERIOD*(elapsed>overhead ? elapsed-overhead : 0);
+            countdown=nextInterval(seed);
+        }
+        if(status!=EVAL_OK) break;
+    }
+    stats.steps=steps;
+    stats.milliseconds=millisecondsSince(started);
+    stats.lineNumber=pc<count ? exec_lines[pc].lineNumber : -1;
+    return status;
+}
+
+void Program::setProfiling(bool flag) {
+    profiling=flag;
+}
+
+void Program::setLimits(long steps, long milliseconds) {
+    if(steps<0 || milliseconds<0) error("LIMIT: negative limit");
+    bool limited=step_limit!=0 || time_limit_ms!=0;
+    if(limited!=(steps!=0 || milliseconds!=0)) invalidate();   //计数与不计数的 bytecode 不同
+    step_limit=steps;
+    time_limit_ms=milliseconds;
+}
+
+long Program::getStepLimit() const {
+    return step_limit;
+}
+
+long Program::getTimeLimit() const {
+    return time_limit_ms;
+}
+
+const RunStats &Program::lastRun() const {
+    return last_run;
+}
+
+void Program::printProfile(std::ostream &out) const {
+    std::vector<LineProfile> rows;
+    uint64_t total=0;
+    for(const LineProfile &row: profile){
+        if(row.count==0) continue;
+        rows.push_back(row);
+        total+=row.ticks;
     }
+    std::sort(rows.begin(),rows.end(),[](const LineProfile &a,const LineProfile &b){
+        return a.ticks!=b.ticks ? a.ticks>b.ticks : a.lineNumber<b.lineNumber;
+    });
+    std::ios_base::fmtflags flags=out.flags();
+    std::streamsize precision=out.precision();
+    out<<std::setw(8)<<"LINE"<<std::setw(14)<<"COUNT"<<std::setw(18)<<"TICKS"<<std::setw(9)<<"TIME"<<'\n';
+    for(const LineProfile &row: rows){
+        double share=total==0 ? 0 : 100.0*double(row.ticks)/double(total);
+        out<<std::setw(8)<<row.lineNumber<<std::setw(14)<<row.count<<std::setw(18)<<row.ticks
+           <<std::setw(8)<<std::fixed<<std::setprecision(1)<<share<<"%\n";
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+Arena &Program::getArena() {
+    return arena;
+}
+
+void Program::setBytecodeEnabled(bool flag) {
+    use_bytecode=flag;
+}
+
+void Program::setJitEnabled(bool flag) {
+    use_jit=flag;
+}
+
+void Program::invalidate() {
+    delete bytecode;
+    bytecode=nullptr;
+    delete jit;
+    jit=nullptr;
+    jit_tried=false;
+    linked=false;
+}
+
+/*
+ * Implementation notes: link
+ * --------------------------
+ * Any edit of the program can create or remove a jump target, so every
+ * edit clears the linked flag and the next tree-interpreted RUN lays
+ * the program out again before the first statement executes.  Lines
+ * without a parsed statement get no entry in exec_lines; a jump to one
+ * of them continues with the next statement, as it always has.
+ */
+
+void Program::link() {
+    exec_lines.clear();
+    line_index.clear();
+    exec_lines.reserve(program_map.size());
+    line_index.reserve(program_map.size());
+    for(auto it=program_map.begin();it!=program_map.end();it++){
+        line_index.emplace_back(it->first,int(exec_lines.size()));
+        if(it->second.stmt!=nullptr) exec_lines.push_back({it->first,it->second.stmt});
+    }
+    for(auto it=program_map.begin();it!=program_map.end();it++){
+        if(it->second.stmt!=nullptr) it->second.stmt->link(*this);
+    }
+    linked=true;
+}
+
+int Program::findLineIndex(int lineNumber) const {
+    auto it=std::lower_bound(line_index.begin(),line_index.end(),std::make_pair(lineNumber,INT_MIN));
+    if(it==line_index.end() || it->first!=lineNumber) return NO_LINE;
+    return it->second;
 }
 
 void Program::list() {
@@ -8,19 +8,145 @@
 #ifndef _program_h
 #define _program_h
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <map>
 #include <set>
 #include <unordered_map>
+#include "arena.hpp"
 #include "statement.hpp"
 
 
 
 class Statement;
+class Bytecode;
+class JitCode;
 
 struct node {
     std::string source_line;
     Statement * stmt = nullptr;
+    LineArena arena;     //这一行语句和表达式结点所在的内存
+};
+
+/*
+ * Type: ExecLine
+ * --------------
+ * One entry of the flat layout the tree interpreter runs from.  The
+ * entries are stored contiguously in line-number order, so falling
+ * through to the next statement is an index increment.
+ */
+
+struct ExecLine {
+    int lineNumber;
+    const Statement *stmt;
+};
+
+/*
+ * Type: LineProfile
+ * -----------------
+ * What the profiler recorded for one line during the last profiled
+ * RUN: how often its statement executed and an estimate, from timing
+ * a sample of the executions, of the ticks spent in it.  Ticks are TSC
+ * cycles on x86-64 and nanoseconds elsewhere.
+ */
+
+struct LineProfile {
+    int lineNumber;
+    long count;
+    uint64_t ticks;
+};
+
+/*
+ * Type: RunStats
+ * --------------
+ * Progress counters of the last RUN that went through the profiler or
+ * the limits: the statements executed, the elapsed wall time and the
+ * line that was about to run when the program stopped (-1 if it ran
+ * to the end).
+ */
+
+struct RunStats {
+    long steps = 0;
+    long milliseconds = 0;
+    int lineNumber = -1;
+};
+
+/*
+ * Class: RunLimiter
+ * -----------------
+ * The step and time limits of one limited RUN in the VM or the JIT.
+ * Bytecode compiled for a limited RUN starts every line with OP_LINE,
+ * which counts down the statements that may start before the limits
+ * are looked at again.  When the countdown runs out, check compares
+ * the steps with the step limit, reads the clock and grants the next
+ * batch, so the clock is read once every CLOCK_INTERVAL statements, as
+ * in the tree interpreter, and the step count is exact.
+ */
+
+class RunLimiter {
+
+public:
+
+    RunLimiter(long stepLimit, long timeLimit);
+
+/*
+ * Method: startStatement
+ * Usage: if (!limiter.startStatement()) status = limiter.check(lineNumber);
+ * -------------------------------------------------------------------------
+ * Counts a statement about to start.  Returns false when the current
+ * batch is used up and check must be called before it runs.
+ */
+
+    bool startStatement() {
+        return --countdown >= 0;
+    }
+
+/*
+ * Method: check
+ * Usage: EvalStatus status = limiter.check(lineNumber);
+ * -----------------------------------------------------
+ * Called before the statement on lineNumber when startStatement has
+ * returned false.  Returns EVAL_STEP_LIMIT or EVAL_TIME_LIMIT if the
+ * statement must not run; otherwise counts it and grants a new batch.
+ */
+
+    EvalStatus check(int lineNumber);
+
+/*
+ * Method: finish
+ * Usage: limiter.finish(stats);
+ * -----------------------------
+ * Stores the counters of the run in stats, as the tree interpreter
+ * reports them.
+ */
+
+    void finish(RunStats &stats) const;
+
+/*
+ * Method: countdownOffset
+ * Usage: size_t offset = RunLimiter::countdownOffset();
+ * -----------------------------------------------------
+ * Returns the offset of the countdown in the object, for the JIT,
+ * which decrements it in place.
+ */
+
+    static size_t countdownOffset();
+
+private:
+
+    int countdown = 0;          //本批还能开始的语句数，减到负数时调用 check
+    int granted = 0;            //本批一共给了多少条
+    long steps = 0;             //之前各批的语句数之和
+    long stepLimit;
+    long timeLimit;
+    int stoppedAt = -1;
+    std::chrono::steady_clock::time_point started;
+
 };
 
 /*
@@ -80,6 +206,19 @@ public:
 
     void addSourceLine(int lineNumber, const std::string& line);
 
+/*
+ * Method: addParsedLine
+ * Usage: program.addParsedLine(lineNumber, line, stmt);
+ * -----------------------------------------------------
+ * Combines addSourceLine and setParsedStatement in a single map
+ * operation.  Lines arriving in increasing order, as they do when a
+ * program file is loaded, are appended without a search.  The line
+ * takes over the arena its nodes were parsed into; the arena of a
+ * replaced line goes back to the program's pool.
+ */
+
+    void addParsedLine(int lineNumber, std::string_view line, Statement *stmt, LineArena arena = LineArena());
+
 /*
  * Method: removeSourceLine
  * Usage: program.removeSourceLine(lineNumber);
@@ -146,9 +285,127 @@ public:
 
     int getNextLineNumber(int lineNumber);
 
-    void execute_all(EvalState & state);
-    //more func to add
-    //todo
+/*
+ * Method: execute_all
+ * Usage: program.execute_all(state);
+ * ----------------------------------
+ * Runs the program from its first line.  By default the program is
+ * compiled to bytecode (cached until the next change to the program)
+ * and executed by the VirtualMachine, or as native code when the JIT
+ * can translate it; setBytecodeEnabled(false) selects the tree-walking
+ * interpreter instead.  Returns the status of the
+ * error that stopped the program, or EVAL_OK.
+ */
+
+    EvalStatus execute_all(EvalState & state);
+
+/*
+ * Methods: prepare, run
+ * Usage: program.prepare();
+ *        EvalStatus status = program.run(state, stats);
+ * ----------------------------------------------------
+ * The two halves of an unprofiled execute_all.  prepare does the work
+ * that is cached between RUNs: compiling the program, or laying it out
+ * for the tree interpreter.  run then executes it on state with the
+ * current engine and limits, leaving the progress counters of a
+ * limited run in stats, and changes nothing in the Program.  Between
+ * prepare and the next edit, set* call or execute_all, run may be
+ * called from several threads at once, each with its own EvalState.
+ */
+
+    void prepare();
+
+    EvalStatus run(EvalState & state, RunStats & stats) const;
+
+/*
+ * Method: setBytecodeEnabled
+ * Usage: program.setBytecodeEnabled(false);
+ * -----------------------------------------
+ * Chooses between the bytecode VM and the tree interpreter for RUN.
+ */
+
+    void setBytecodeEnabled(bool flag);
+
+/*
+ * Method: setJitEnabled
+ * Usage: program.setJitEnabled(false);
+ * ------------------------------------
+ * Chooses whether bytecode RUNs go through the native-code JIT, which
+ * is on by default.  Programs the JIT cannot translate run in the VM
+ * either way.
+ */
+
+    void setJitEnabled(bool flag);
+
+/*
+ * Method: setProfiling
+ * Usage: program.setProfiling(true);
+ * ----------------------------------
+ * Turns the per-line profiler on or off for later RUNs.  A profiled
+ * RUN always uses the tree interpreter, which executes exactly one
+ * statement per line; with profiling off RUN is not affected at all.
+ */
+
+    void setProfiling(bool flag);
+
+/*
+ * Method: printProfile
+ * Usage: program.printProfile(std::cout);
+ * ---------------------------------------
+ * Writes the profile of the last profiled RUN, one row per executed
+ * line, most expensive line first.
+ */
+
+    void printProfile(std::ostream &out) const;
+
+/*
+ * Method: setLimits
+ * Usage: program.setLimits(steps, milliseconds);
+ * ----------------------------------------------
+ * Limits later RUNs to the given number of executed statements and
+ * milliseconds of wall time; 0 means no limit, and a negative value
+ * is an error, which leaves the limits unchanged.  A RUN that reaches a
+ * limit stops with EVAL_STEP_LIMIT or EVAL_TIME_LIMIT.  A limited RUN
+ * keeps its engine: the bytecode is compiled with a step counter at
+ * the start of every line, which the VM and the JIT run through a
+ * RunLimiter.
+ */
+
+    void setLimits(long steps, long milliseconds);
+
+    long getStepLimit() const;
+
+    long getTimeLimit() const;
+
+/*
+ * Method: lastRun
+ * Usage: const RunStats &stats = program.lastRun();
+ * -------------------------------------------------
+ * Returns the progress counters of the last profiled or limited RUN.
+ */
+
+    const RunStats &lastRun() const;
+
+/*
+ * Method: getArena
+ * Usage: LineArena arena(program.getArena());
+ * -------------------------------------------
+ * Returns the chunk pool from which the program's line arenas are
+ * allocated.  clear() releases it in bulk.
+ */
+
+    Arena &getArena();
+
+/*
+ * Method: findLineIndex
+ * Usage: int index = program.findLineIndex(lineNumber);
+ * -----------------------------------------------------
+ * Returns the position in the flat layout where execution continues
+ * when jumping to lineNumber, or NO_LINE if the program has no such
+ * line.  Only valid while Program links its statements before RUN.
+ */
+
+    int findLineIndex(int lineNumber) const;
 
     void list();
 
@@ -157,6 +414,28 @@ public:
 
 private:
 
+    bool use_bytecode = true;
+    Arena arena;                    //所有行的 LineArena 从这里取 chunk
+    Bytecode *bytecode = nullptr;   //编译结果的缓存，程序改动时失效
+    bool use_jit = true;
+    bool jit_tried = false;         //本次的 bytecode 是否已尝试过 JIT
+    JitCode *jit = nullptr;         //nullptr 时退回 VM
+    bool linked = false;            //flat 布局是否已建好、跳转目标是否已解析
+    std::vector<ExecLine> exec_lines;                //有语句的行，按行号连续存放
+    std::vector<std::pair<int,int>> line_index;      //行号 -> exec_lines 下标
+    bool profiling = false;
+    std::vector<LineProfile> profile;                //与 exec_lines 一一对应
+    long step_limit = 0;                             //0 表示不限制
+    long time_limit_ms = 0;
+    RunStats last_run;
+
+    template <bool PROFILE, bool LIMIT>
+    EvalStatus execute_instrumented(EvalState & state, RunStats & stats, std::vector<LineProfile> & line_profile) const;
+
+    void invalidate();
+
+    void link();
+
 
     // Fill this in with whatever types and instance variables you need
     //todo
@@ -8,6 +8,8 @@
  */
 
 #include "statement.hpp"
+#include "inputdata.hpp"
+#include "output.hpp"
 
 
 /* Implementation of the Statement class */
@@ -17,10 +19,22 @@ Statement::Statement() = default;
 
 Statement::~Statement() = default;
 
+void Statement::resolve(EvalState &state) {
+    /* Empty */
+}
+
+void Statement::link(Program &program) {
+    /* Empty */
+}
+
 /* Implementation notes: the LetStatement subclass */
 
 RemStatement::RemStatement() {}
 
+StatementType RemStatement::getType() const {
+    return REM_STMT;
+}
+
 
 bool IsLegalInteger_state(std::string a){
     for(int i=0;i<a.length();i++){
@@ -38,51 +52,81 @@ LetStatement::~LetStatement() {
     delete exp;
 }
 
-void LetStatement::execute(EvalState &state, Program &program,std::map<int,node>::iterator &it) {
-    std::string error_message;
-    value=exp->eval_not_delete(state, error_message);
-    if(!error_message.empty()) error(error_message);
-    state.setValue(var,value);
+EvalStatus LetStatement::execute(EvalState &state, int &next) const {
+    EvalStatus status=EVAL_OK;
+    int value=exp->eval_not_delete(state, status);
+    if(status!=EVAL_OK) return status;
+    state.setValue(slot,value);
+    return EVAL_OK;
+}
+
+StatementType LetStatement::getType() const {
+    return LET_STMT;
+}
+
+void LetStatement::resolve(EvalState &state) {
+    slot=state.intern(var);
+    exp->resolve(state);
+}
+
+const std::string &LetStatement::getVar() const {
+    return var;
+}
+
+int LetStatement::getSlot() const {
+    return slot;
+}
+
+Expression *LetStatement::getExp() const {
+    return exp;
 }
 
 
-IfStatement::IfStatement(Expression *lhs_exp, std::string op,Expression *rhs_exp, int num) {
-    this->lhs_exp=lhs_exp;
-    this->op=op;
-    this->rhs_exp=rhs_exp;
+IfStatement::IfStatement(CompoundExp *condition, int num) {
+    this->condition=condition;
     this->num=num;
 }
 
-void IfStatement::execute(EvalState &state, Program &program,std::map<int,node>::iterator &it) {
-    bool flag=false;
-    std::string error_message;
-    int value1=lhs_exp->eval_not_delete(state,error_message);
-    if(!error_message.empty()){
-        std::cout<<error_message<<'\n';
-        return;
+EvalStatus IfStatement::execute(EvalState &state, int &next) const {
+    EvalStatus status=EVAL_OK;
+    bool flag=condition->eval_not_delete(state,status);
+    if(status!=EVAL_OK){
+        output().printLine(statusMessage(status));   //IF 中的错误只打印，继续执行下一行
+        return EVAL_OK;
     }
-    int value2=rhs_exp->eval_not_delete(state,error_message);
-    if(!error_message.empty()){
-        std::cout<<error_message<<'\n';
-        return;
-    }
-    if(op=="=" && value1==value2) flag= true;
-    if(op=="<" && value1<value2) flag= true;
-    if(op==">" && value1>value2) flag= true;
     if(flag){
-        auto itt=program.program_map.find(num);
-        if(itt==program.program_map.end()){
-            std::cout<<"LINE NUMBER ERROR\n";
+        if(target==NO_LINE){
+            output().printLine("LINE NUMBER ERROR");
         }else{
-            it=itt;
+            next=target;
         }
     }
+    return EVAL_OK;
 
 }
 
 IfStatement::~IfStatement() {
-    delete lhs_exp;
-    delete rhs_exp;
+    delete condition;
+}
+
+StatementType IfStatement::getType() const {
+    return IF_STMT;
+}
+
+void IfStatement::resolve(EvalState &state) {
+    condition->resolve(state);
+}
+
+void IfStatement::link(Program &program) {
+    target=program.findLineIndex(num);
+}
+
+CompoundExp *IfStatement::getCondition() const {
+    return condition;
+}
+
+int IfStatement::getTarget() const {
+    return num;
 }
 
 PrintStatement::PrintStatement(Expression *exp) {
@@ -93,11 +137,24 @@ PrintStatement::~PrintStatement() {
     delete exp;
 }
 
-void PrintStatement::execute(EvalState &state, Program &program,std::map<int,node>::iterator &it) {
-    std::string error_message;
-    value=exp->eval_not_delete(state, error_message);
-    if(!error_message.empty()) error(error_message);
-    std::cout << value<<'\n';
+EvalStatus PrintStatement::execute(EvalState &state, int &next) const {
+    EvalStatus status=EVAL_OK;
+    int value=exp->eval_not_delete(state, status);
+    if(status!=EVAL_OK) return status;
+    output().printInteger(value);
+    return EVAL_OK;
+}
+
+StatementType PrintStatement::getType() const {
+    return PRINT_STMT;
+}
+
+void PrintStatement::resolve(EvalState &state) {
+    exp->resolve(state);
+}
+
+Expression *PrintStatement::getExp() const {
+    return exp;
 }
 
 
@@ -106,36 +163,88 @@ InputStatement::InputStatement(std::string var) {
     this->var=var;
 }
 
-void InputStatement::execute(EvalState &state, Program &program,std::map<int,node>::iterator &it) {
-    std::cout<<" ? ";
-    std::string value;
-    getline(std::cin, value);
-    while(!IsLegalInteger_state(value)){
+EvalStatus InputStatement::execute(EvalState &state, int &next) const {
+    int value;
+    EvalStatus status=readValue(state,value);
+    if(status!=EVAL_OK) return status;
+    state.setValue(slot,value);
+    return EVAL_OK;
+}
+
+StatementType InputStatement::getType() const {
+    return INPUT_STMT;
+}
+
+void InputStatement::resolve(EvalState &state) {
+    slot=state.intern(var);
+}
+
+const std::string &InputStatement::getVar() const {
+    return var;
+}
+
+int InputStatement::getSlot() const {
+    return slot;
+}
+
+bool InputStatement::prompting = true;
+
+void InputStatement::setPrompting(bool flag) {
+    prompting = flag;
+}
+
+EvalStatus InputStatement::readValue(EvalState &state, int &value) {
+    InputData *data = state.getInputData();
+    if (data != nullptr) {   //数据文件在载入时已全部解析，这里只取下一个值
+        if (prompting) output().printText(" ? ");
+        return data->next(value) ? EVAL_OK : EVAL_INPUT_EXHAUSTED;
+    }
+    if (prompting) std::cout<<" ? ";
+    std::string line;
+    getline(std::cin, line);
+    while(!IsLegalInteger_state(line)){
         std::cout<<"INVALID NUMBER\n";
-        std::cout<<" ? ";
-        getline(std::cin, value);
+        if (prompting) std::cout<<" ? ";
+        getline(std::cin, line);
     }
-    int value_int= stringToInteger(value);
-    state.setValue(var,value_int);
+    value = stringToInteger(line);
+    return EVAL_OK;
 }
 
 EndStatement::EndStatement() {}
 
-void EndStatement::execute(EvalState &state, Program &program,std::map<int,node>::iterator &it) {
-    it=program.program_map.end();
+EvalStatus EndStatement::execute(EvalState &state, int &next) const {
+    next=PROGRAM_END;
+    return EVAL_OK;
 };
 
+StatementType EndStatement::getType() const {
+    return END_STMT;
+}
+
 GotoStatement::GotoStatement(int num) {
     this->num=num;
 }
 
-void GotoStatement::execute(EvalState &state, Program &program,std::map<int,node>::iterator &it) {
-    auto itt=program.program_map.find(num);
-    if(itt==program.program_map.end()) {
-        std::cout<<"LINE NUMBER ERROR\n";
+EvalStatus GotoStatement::execute(EvalState &state, int &next) const {
+    if(target==NO_LINE) {
+        output().printLine("LINE NUMBER ERROR");
     }else{
-        it=itt;
+        next=target;
     }
+    return EVAL_OK;
+}
+
+void GotoStatement::link(Program &program) {
+    target=program.findLineIndex(num);
+}
+
+StatementType GotoStatement::getType() const {
+    return GOTO_STMT;
+}
+
+int GotoStatement::getTarget() const {
+    return num;
 }
 
 //RunStatement::RunStatement() {}
@@ -12,8 +12,10 @@
 #ifndef _statement_h
 #define _statement_h
 
+#include <climits>
 #include <string>
 #include <sstream>
+#include "arena.hpp"
 #include "evalstate.hpp"
 #include "exp.hpp"
 #include "Utils/tokenScanner.hpp"
@@ -25,6 +27,31 @@
 class Program;
 class EvalState;
 struct node;
+
+/*
+ * Type: StatementType
+ * -------------------
+ * This enumerated type is used to differentiate the statement forms
+ * that can appear in a numbered program line.  The bytecode compiler
+ * uses it in the same way the evaluator uses ExpressionType.
+ */
+
+enum StatementType {
+    REM_STMT, LET_STMT, IF_STMT, PRINT_STMT, INPUT_STMT, END_STMT, GOTO_STMT
+};
+
+/*
+ * Constants: NO_LINE, PROGRAM_END
+ * -------------------------------
+ * Positions in the flat statement layout built by Program::link.
+ * NO_LINE marks a jump whose target line does not exist, and a
+ * statement stops the program by setting the next position to
+ * PROGRAM_END.
+ */
+
+const int NO_LINE = -1;
+const int PROGRAM_END = INT_MAX;
+
 /*
  * Class: Statement
  * ----------------
@@ -59,18 +86,68 @@ public:
 
     virtual ~Statement();
 
+/*
+ * Operators: new, delete
+ * Usage: Statement *stmt = new EndStatement();
+ * --------------------------------------------
+ * Statements share the node allocator of the Expression classes, so
+ * a program line's statement sits next to its expression tree.
+ */
+
+    static void *operator new(size_t size) { return allocateNode(size); }
+
+    static void operator delete(void *p) { freeNode(p); }
+
 /*
  * Method: execute
- * Usage: stmt->execute(state);
- * ----------------------------
+ * Usage: stmt->execute(state, next);
+ * ----------------------------------
  * This method executes a BASIC statement.  Each of the subclasses
  * defines its own execute method that implements the necessary
  * operations.  As was true for the expression evaluator, this
  * method takes an EvalState object for looking up variables or
- * controlling the operation of the interpreter.
+ * controlling the operation of the interpreter.  On entry next is
+ * the position of the following statement in the program's flat
+ * layout; jumps overwrite it.  A run-time error that ends the
+ * program is returned as a status instead of thrown.  execute changes
+ * nothing but state and next, so a linked program can be executed by
+ * several threads at once.
+ */
+
+    virtual EvalStatus execute(EvalState &state, int &next) const = 0;
+
+/*
+ * Method: getType
+ * Usage: StatementType type = stmt->getType();
+ * --------------------------------------------
+ * Returns the type of the statement, which can be used to cast the
+ * statement to the subclass that exports the matching accessors.
  */
 
-    virtual void execute(EvalState &state, Program &program,std::map<int,node>::iterator &it) = 0;
+    virtual StatementType getType() const = 0;
+
+/*
+ * Method: resolve
+ * Usage: stmt->resolve(state);
+ * ----------------------------
+ * Binds the variables used by this statement to their slots in state.
+ * processLine runs this pass once, right after the line is parsed.
+ * The default implementation does nothing.
+ */
+
+    virtual void resolve(EvalState &state);
+
+/*
+ * Method: link
+ * Usage: stmt->link(program);
+ * ---------------------------
+ * Resolves the line number this statement jumps to into a position
+ * in the program's flat layout.  Program runs this pass before RUN
+ * whenever lines were added or removed since the last link.  The
+ * default implementation does nothing.
+ */
+
+    virtual void link(Program &program);
 
 };
 
@@ -78,7 +155,9 @@ class RemStatement:public Statement{
 
 public:
     RemStatement();
-    virtual void execute(EvalState &state, Program &program,std::map<int,node>::iterator &it){};
+    virtual EvalStatus execute(EvalState &state, int &next) const {return EVAL_OK;};
+
+    virtual StatementType getType() const;
 };
 
 class LetStatement:public Statement{
@@ -88,28 +167,47 @@ public:
 
     virtual ~LetStatement();
 
-    virtual void execute(EvalState &state, Program &program,std::map<int,node>::iterator &it) ;
+    virtual EvalStatus execute(EvalState &state, int &next) const;
 
+    virtual StatementType getType() const;
+
+    virtual void resolve(EvalState &state);
+
+    const std::string &getVar() const;
+
+    int getSlot() const;
+
+    Expression *getExp() const;
 
 private:
-    int value;
     std::string var;
+    int slot = -1;
     Expression *exp;
 };
 
 class IfStatement:public Statement{
 
 public:
-    IfStatement(Expression *lsh_exp,std::string op,Expression *rhs_exp,int num);
+    IfStatement(CompoundExp *condition,int num);
 
     ~IfStatement();
 
-    virtual void execute(EvalState &state, Program &program,std::map<int,node>::iterator &it) ;
+    virtual EvalStatus execute(EvalState &state, int &next) const;
+
+    virtual StatementType getType() const;
+
+    virtual void resolve(EvalState &state);
+
+    virtual void link(Program &program);
+
+    CompoundExp *getCondition() const;
+
+    int getTarget() const;
 
 private:
-    Expression *lhs_exp,*rhs_exp;
-    std::string op;
+    CompoundExp *condition;   //EqualExp、LessExp 或 GreaterExp
     int num;
+    int target = NO_LINE;   //目标行不存在时跳转报 LINE NUMBER ERROR
 
 };
 
@@ -121,14 +219,18 @@ public:
 
     ~PrintStatement();
 
-    virtual void execute(EvalState &state, Program &program,std::map<int,node>::iterator &it) ;
+    virtual EvalStatus execute(EvalState &state, int &next) const;
+
+    virtual StatementType getType() const;
+
+    virtual void resolve(EvalState &state);
+
+    Expression *getExp() const;
 
 private:
 
     Expression * exp;
 
-    int value;
-
 };
 
 class InputStatement:public Statement{
@@ -137,11 +239,45 @@ public:
 
     InputStatement(std::string var);
 
-    virtual void execute(EvalState &state, Program &program,std::map<int,node>::iterator &it) ;
+    virtual EvalStatus execute(EvalState &state, int &next) const;
+
+    virtual StatementType getType() const;
+
+    virtual void resolve(EvalState &state);
+
+    const std::string &getVar() const;
+
+    int getSlot() const;
+
+/*
+ * Method: readValue
+ * Usage: EvalStatus status = InputStatement::readValue(state, value);
+ * -------------------------------------------------------------------
+ * Prompts on std::cout and reads lines from std::cin until a legal
+ * integer is entered.  If the state has InputData, the next value is
+ * taken from it instead, after the same prompt, and EVAL_INPUT_EXHAUSTED
+ * is returned once it runs out.  Shared by the tree interpreter, the VM
+ * and immediate INPUT.
+ */
+
+    static EvalStatus readValue(EvalState &state, int &value);
+
+/*
+ * Method: setPrompting
+ * Usage: InputStatement::setPrompting(false);
+ * -------------------------------------------
+ * Turns the " ? " prompt of INPUT on or off for all later reads.  The
+ * prompt is on by default.
+ */
+
+    static void setPrompting(bool flag);
 
 private:
 
+    static bool prompting;
+
     std::string var;
+    int slot = -1;
 };
 
 class EndStatement:public Statement{
@@ -149,7 +285,9 @@ public:
 
     EndStatement();
 
-    virtual void execute(EvalState &state, Program &program,std::map<int,node>::iterator &it) ;
+    virtual EvalStatus execute(EvalState &state, int &next) const;
+
+    virtual StatementType getType() const;
 
 };
 
@@ -159,11 +297,18 @@ public:
 
     GotoStatement(int num);
 
-    virtual void execute(EvalState &state, Program &program,std::map<int,node>::iterator &it) ;
+    virtual EvalStatus execute(EvalState &state, int &next) const;
+
+    virtual StatementType getType() const;
+
+    virtual void link(Program &program);
+
+    int getTarget() const;
 
 private:
 
     int num;
+    int target = NO_LINE;
 
 };
 //
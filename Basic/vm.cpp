@@ -0,0 +1,167 @@
+/*
+ * File: vm.cpp
+ * ------------
+ * This file implements the VirtualMachine class.
+ */
+
+#include <vector>
+#include "vm.hpp"
+#include "output.hpp"
+
+/*
+ * Implementation notes: dispatch
+ * ------------------------------
+ * The dispatch loop keeps the program counter, the code pointer and the
+ * operand stack pointer in locals.  It is written once with the macros
+ * below and instantiated twice.  The switch version goes back to the
+ * switch after every instruction.  When the compiler supports labels
+ * as values (BASIC_COMPUTED_GOTO, set in CMakeLists.txt), the threaded
+ * version ends each instruction with an indirect jump straight to the
+ * code of the next one, which gives every opcode its own branch in the
+ * predictor.  A failing instruction jumps to fail.  Inside an IF
+ * statement the message is printed and the next line runs; anywhere
+ * else the status is returned to the caller.
+ */
+
+#define FETCH() (op = code[pc], arg = code[pc + 1], pc += 2)
+#define FAIL(s) { status = s; goto fail; }
+#ifdef BASIC_COMPUTED_GOTO
+#define TARGET(name) case name: L_##name:
+#define NEXT() { if constexpr (THREADED) { FETCH(); goto *labels[op]; } else { continue; } }
+#else
+#define TARGET(name) case name:
+#define NEXT() { continue; }
+#endif
+
+template <bool THREADED>
+static EvalStatus dispatch(const Bytecode &bytecode, EvalState &state, RunLimiter *limiter) {
+    std::vector<int> stack(bytecode.maxStack + 1);
+    int *base = stack.data();
+    int *sp = base;
+    const int *code = bytecode.code.data();
+    EvalStatus status = EVAL_OK;
+    int pc = 0, op, arg, input;
+#ifdef BASIC_COMPUTED_GOTO
+    static const void *const labels[] = {   //与 OpCode 的顺序一致
+        &&L_OP_CONST, &&L_OP_LOAD, &&L_OP_STORE, &&L_OP_ASSIGN,
+        &&L_OP_ADD, &&L_OP_SUB, &&L_OP_MUL, &&L_OP_DIV, &&L_OP_FAIL,
+        &&L_OP_PRINT, &&L_OP_INPUT,
+        &&L_OP_JUMP, &&L_OP_JUMP_EQ, &&L_OP_JUMP_LT, &&L_OP_JUMP_GT, &&L_OP_LINE_ERROR,
+        &&L_OP_LINE, &&L_OP_HALT
+    };
+#endif
+    while (true) {
+        FETCH();
+        switch (op) {
+            TARGET(OP_CONST)
+                *sp++ = arg;
+                NEXT();
+            TARGET(OP_LOAD)
+                if (!state.isDefined(arg)) FAIL(EVAL_UNDEFINED_VARIABLE);
+                *sp++ = state.getValue(arg);
+                NEXT();
+            TARGET(OP_STORE)
+                state.setValue(arg, *--sp);
+                NEXT();
+            TARGET(OP_ASSIGN)
+                state.setValue(arg, sp[-1]);
+                NEXT();
+            TARGET(OP_ADD)
+                sp--;
+                sp[-1] += *sp;
+                NEXT();
+            TARGET(OP_SUB)
+                sp--;
+                sp[-1] -= *sp;
+                NEXT();
+            TARGET(OP_MUL)
+                sp--;
+                sp[-1] *= *sp;
+                NEXT();
+            TARGET(OP_DIV)
+                if (sp[-1] == 0) FAIL(EVAL_DIVIDE_BY_ZERO);
+                sp--;
+                sp[-1] /= *sp;
+                NEXT();
+            TARGET(OP_FAIL)
+                FAIL(EvalStatus(arg));
+            TARGET(OP_PRINT)
+                output().printInteger(*--sp);
+                NEXT();
+            TARGET(OP_INPUT)
+                status = InputStatement::readValue(state, input);
+                if (status != EVAL_OK) goto fail;
+                state.setValue(arg, input);
+                NEXT();
+            TARGET(OP_JUMP)
+                pc = arg;
+                NEXT();
+            TARGET(OP_JUMP_EQ)
+                sp -= 2;
+                if (sp[0] != sp[1]) NEXT();
+                goto jump;
+            TARGET(OP_JUMP_LT)
+                sp -= 2;
+                if (!(sp[0] < sp[1])) NEXT();
+                goto jump;
+            TARGET(OP_JUMP_GT)
+                sp -= 2;
+                if (!(sp[0] > sp[1])) NEXT();
+            jump:
+                if (arg == NO_TARGET) {
+                    output().printLine("LINE NUMBER ERROR");
+                    NEXT();
+                }
+                pc = arg;
+                NEXT();
+            TARGET(OP_LINE_ERROR)
+                output().printLine("LINE NUMBER ERROR");
+                NEXT();
+            TARGET(OP_LINE)
+                if (limiter->startStatement()) NEXT();
+                status = limiter->check(arg);
+                if (status != EVAL_OK) return status;   //超出限制不是 IF 中的错误，直接结束
+                NEXT();
+            TARGET(OP_HALT)
+            default:
+                return EVAL_OK;
+        }
+    fail:
+        const LineInfo *info = bytecode.findLine(pc - 2);
+        if (info == nullptr || info->type != IF_STMT) return status;
+        output().printLine(statusMessage(status));
+        status = EVAL_OK;
+        pc = bytecode.nextLinePc(info);
+        sp = base;
+    }
+}
+
+#undef FETCH
+#undef TARGET
+#undef FAIL
+#undef NEXT
+
+#ifdef BASIC_COMPUTED_GOTO
+bool VirtualMachine::threaded = true;
+#else
+bool VirtualMachine::threaded = false;
+#endif
+
+EvalStatus VirtualMachine::run(const Bytecode &bytecode, EvalState &state, RunLimiter *limiter) {
+#ifdef BASIC_COMPUTED_GOTO
+    if (threaded) return dispatch<true>(bytecode, state, limiter);
+#endif
+    return dispatch<false>(bytecode, state, limiter);
+}
+
+bool VirtualMachine::threadedAvailable() {
+#ifdef BASIC_COMPUTED_GOTO
+    return true;
+#else
+    return false;
+#endif
+}
+
+void VirtualMachine::setThreaded(bool flag) {
+    threaded = flag && threadedAvailable();
+}
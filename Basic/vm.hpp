@@ -0,0 +1,64 @@
+/*
+ * File: vm.h
+ * ----------
+ * This interface exports the VirtualMachine class, which executes the
+ * bytecode produced by BytecodeCompiler.  It is the default engine
+ * behind RUN; the tree-walking interpreter in Program::execute_all is
+ * kept as a fallback so that the outputs of both can be compared.
+ */
+
+#ifndef _vm_h
+#define _vm_h
+
+#include <string>
+#include "bytecode.hpp"
+#include "evalstate.hpp"
+
+/*
+ * Class: VirtualMachine
+ * ---------------------
+ * A stack machine that runs one Bytecode object against an EvalState.
+ * Run-time errors follow the tree interpreter: inside an IF statement
+ * the message is printed and execution continues with the next line,
+ * anywhere else the program stops and run returns the status.
+ */
+
+class VirtualMachine {
+
+public:
+
+/*
+ * Method: run
+ * Usage: EvalStatus status = vm.run(bytecode, state);
+ *        EvalStatus status = vm.run(bytecode, state, &limiter);
+ * -------------------------------------------------------------
+ * Executes the bytecode from its first instruction until OP_HALT or
+ * an error outside an IF statement, whose status is returned.  Code
+ * compiled with countSteps needs a limiter, which stops it with
+ * EVAL_STEP_LIMIT or EVAL_TIME_LIMIT.
+ */
+
+    EvalStatus run(const Bytecode &bytecode, EvalState &state, RunLimiter *limiter = nullptr);
+
+/*
+ * Methods: threadedAvailable, setThreaded
+ * Usage: VirtualMachine::setThreaded(false);
+ * ------------------------------------------
+ * The VM has a portable switch-based dispatch loop and, when built
+ * with BASIC_THREADED_DISPATCH on GCC or Clang, a threaded loop using
+ * computed goto, which is then the default.  setThreaded chooses
+ * between them for all later runs; asking for the threaded loop has
+ * no effect when it was not built.
+ */
+
+    static bool threadedAvailable();
+
+    static void setThreaded(bool flag);
+
+private:
+
+    static bool threaded;
+
+};
+
+#endif
@@ -0,0 +1,332 @@
+/*
+ * File: bench_suite.cpp
+ * ---------------------
+ * Performance regression suite.  Generates a set of heavy BASIC
+ * programs, runs each one several times through the interpreter and
+ * reports, per workload:
+ *
+ *   median, p90, min and max wall time
+ *   statements executed per second (at the median)
+ *   peak resident set size of the interpreter process
+ *
+ * The statement count of a workload is taken once from the profiler
+ * (--profile), so it is exact whatever the generator does.  Results are
+ * written as JSON, tagged with the host they were measured on.
+ *
+ * Timings are only comparable on one host, so there is no baseline in
+ * the tree.  Given --baseline, the suite compares with that file if it
+ * was recorded on this host: workloads whose median is slower than the
+ * baseline by more than the threshold are reported as regressions.  If
+ * the file is missing or comes from another host, this run is recorded
+ * in it as the baseline and nothing is compared; a run limited by
+ * --only is not recorded.  Delete the file to record a new baseline.
+ *
+ * On a shared machine medians vary by 30% and more from run to run, so
+ * the default threshold is 50% and the comparison is advisory: the
+ * suite exits with status 1 on a regression only with --strict, which
+ * is meant for a quiet machine.
+ *
+ * Usage: bench_suite path/to/code [--runs N] [--output results.json]
+ *                    [--baseline baseline.json] [--threshold percent]
+ *                    [--strict] [--only workload] [-- interpreter options]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* Workload generators */
+
+static std::string deepLoops() {
+    return "10 LET i = 0\n"
+           "20 LET j = 0\n"
+           "30 LET k = 0\n"
+           "40 LET s = s + i * j - k\n"
+           "50 LET k = k + 1\n"
+           "60 IF k < 100 THEN 40\n"
+           "70 LET j = j + 1\n"
+           "80 IF j < 200 THEN 30\n"
+           "90 LET i = i + 1\n"
+           "100 IF i < 1500 THEN 20\n"
+           "5 LET s = 0\n";
+}
+
+static std::string straightLine() {
+    std::string source = "1 LET n = 0\n";
+    int line = 10;
+    for (int i = 0; i < 20000; i++, line += 10) {
+        source += std::to_string(line) + " LET a" + std::to_string(i % 10) + " = " + std::to_string(i) + " + n\n";
+    }
+    source += std::to_string(line) + " LET n = n + 1\n";
+    source += std::to_string(line + 10) + " IF n < 1500 THEN 10\n";
+    return source;
+}
+
+static std::string hugeProgram() {
+    std::string source;
+    for (int i = 1; i <= 200000; i++) {
+        if (i % 3 == 0) source += std::to_string(i) + " REM line " + std::to_string(i) + "\n";
+        else source += std::to_string(i) + " LET v" + std::to_string(i % 50) + " = " + std::to_string(i) + " * 2 - 1\n";
+    }
+    return source;
+}
+
+static std::string expressionHeavy() {
+    std::string expression = "x";
+    for (int i = 1; i <= 60; i++) {
+        const char *op = i % 4 == 0 ? " - " : i % 4 == 1 ? " + " : i % 4 == 2 ? " * " : " / ";
+        expression = i % 8 == 0 ? "(" + expression + ")" + op + "(x + " + std::to_string(i) + ")"
+                                : expression + op + std::to_string(i % 7 + 1);
+    }
+    return "10 LET x = 0\n"
+           "20 LET y = " + expression + "\n"
+           "30 LET z = y - " + expression + "\n"
+           "40 LET x = x + 1\n"
+           "50 IF x < 4000000 THEN 20\n";
+}
+
+static std::string manyVariables() {
+    std::string source = "1 LET r = 0\n";
+    int line = 10;
+    for (int i = 0; i < 5000; i++, line += 10) {
+        source += std::to_string(line) + " LET var" + std::to_string(i) + " = " + std::to_string(i) + " + r\n";
+    }
+    for (int i = 0; i < 5000; i++, line += 10) {
+        source += std::to_string(line) + " LET total = total + var" + std::to_string(4999 - i) + "\n";
+    }
+    source += std::to_string(line) + " LET r = r + 1\n";
+    source += std::to_string(line + 10) + " IF r < 3000 THEN 2\n";
+    source += "2 LET total = 0\n";
+    return source;
+}
+
+struct Workload {
+    const char *name;
+    std::function<std::string()> generate;
+};
+
+static const std::vector<Workload> WORKLOADS = {
+    {"deep_loops", deepLoops},
+    {"straight_line", straightLine},
+    {"huge_program", hugeProgram},
+    {"expression_heavy", expressionHeavy},
+    {"many_variables", manyVariables},
+};
+
+/* Running the interpreter */
+
+struct Sample {
+    double seconds;
+    long peakRssKb;
+};
+
+// 以 /dev/null 为输入运行 code --load path --run，等待结束并取得峰值 RSS
+static Sample runOnce(const std::vector<std::string> &args) {
+    std::vector<char *> argv;
+    for (const std::string &arg: args) argv.push_back(const_cast<char *>(arg.c_str()));
+    argv.push_back(nullptr);
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid == 0) {
+        int null = open("/dev/null", O_RDWR);
+        dup2(null, 0);
+        dup2(null, 1);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+    int status = 0;
+    rusage usage{};
+    if (pid < 0 || wait4(pid, &status, 0, &usage) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::cerr << "bench_suite: " << args[0] << " failed\n";
+        std::exit(2);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return {seconds, usage.ru_maxrss};
+}
+
+static long countStatements(const std::vector<std::string> &command, const std::string &profilePath) {
+    std::vector<std::string> args = command;
+    args.push_back("--profile");
+    args.push_back(profilePath);
+    runOnce(args);
+    std::ifstream in(profilePath);
+    std::string header, line;
+    std::getline(in, header);
+    long total = 0;
+    while (std::getline(in, line)) {
+        std::istringstream row(line);
+        long lineNumber = 0, count = 0;
+        row >> lineNumber >> count;
+        total += count;
+    }
+    std::remove(profilePath.c_str());
+    return total;
+}
+
+static double percentile(const std::vector<double> &sorted, double p) {
+    double index = p * double(sorted.size() - 1);
+    size_t lower = size_t(index);
+    size_t upper = std::min(lower + 1, sorted.size() - 1);
+    return sorted[lower] + (sorted[upper] - sorted[lower]) * (index - double(lower));
+}
+
+/* Results */
+
+// 主机名加 CPU 型号；只有同一台机器上的计时才能比较
+static std::string hostKey() {
+    char name[HOST_NAME_MAX + 1] = "";
+    gethostname(name, sizeof name);
+    std::string key = name, line;
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    while (std::getline(cpuinfo, line)) {
+        if (line.compare(0, 10, "model name") != 0) continue;
+        key += " / " + line.substr(line.find(':') + 2);
+        break;
+    }
+    std::replace(key.begin(), key.end(), '"', '\'');
+    std::replace(key.begin(), key.end(), '\\', '/');
+    return key;
+}
+
+struct Result {
+    std::string name;
+    double median, p90, min, max;
+    long statements;
+    double statementsPerSecond;
+    long peakRssKb;
+};
+
+static void writeJson(const std::vector<Result> &results, const std::string &host, const std::string &path) {
+    std::ofstream out(path);
+    out << "{\n"
+        << "  \"host\": \"" << host << "\",\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        char buffer[512];
+        std::snprintf(buffer, sizeof buffer,
+                      "  \"%s\": {\"median_s\": %.6f, \"p90_s\": %.6f, \"min_s\": %.6f, \"max_s\": %.6f, "
+                      "\"statements\": %ld, \"statements_per_s\": %.0f, \"peak_rss_kb\": %ld}%s\n",
+                      r.name.c_str(), r.median, r.p90, r.min, r.max, r.statements, r.statementsPerSecond,
+                      r.peakRssKb, i + 1 < results.size() ? "," : "");
+        out << buffer;
+    }
+    out << "}\n";
+}
+
+// 只认本程序写出的格式：一行 host，每个 workload 一行，取其中的 median_s
+static bool readBaseline(const std::string &path, std::string &host, std::map<std::string, double> &medians) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t tag = line.find("\"host\": \"");
+        if (tag != std::string::npos) {
+            size_t start = tag + 9;
+            host = line.substr(start, line.find('"', start) - start);
+            continue;
+        }
+        size_t open = line.find('"'), close = line.find('"', open + 1);
+        size_t key = line.find("\"median_s\":");
+        if (open == std::string::npos || close == std::string::npos || key == std::string::npos) continue;
+        medians[line.substr(open + 1, close - open - 1)] = std::atof(line.c_str() + key + 11);
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "usage: bench_suite path/to/code [--runs N] [--output results.json]\n"
+                     "                   [--baseline baseline.json] [--threshold percent]\n"
+                     "                   [--strict] [--only workload] [-- interpreter options]\n";
+        return 2;
+    }
+    std::string code = argv[1];
+    int runs = 7;
+    std::string output = "bench_results.json", baseline, only;
+    double threshold = 50;
+    bool strict = false;
+    std::vector<std::string> extra;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--runs" && i + 1 < argc) runs = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--output" && i + 1 < argc) output = argv[++i];
+        else if (arg == "--baseline" && i + 1 < argc) baseline = argv[++i];
+        else if (arg == "--threshold" && i + 1 < argc) threshold = std::atof(argv[++i]);
+        else if (arg == "--only" && i + 1 < argc) only = argv[++i];
+        else if (arg == "--strict") strict = true;
+        else if (arg == "--") {
+            extra.assign(argv + i + 1, argv + argc);
+            break;
+        }
+    }
+
+    std::vector<Result> results;
+    std::string programPath = "bench_suite_program.bas";
+    std::printf("%-17s %9s %9s %9s %12s %12s %10s\n",
+                "workload", "median", "p90", "min", "statements", "stmts/s", "peak RSS");
+    for (const Workload &workload: WORKLOADS) {
+        if (!only.empty() && only != workload.name) continue;
+        std::ofstream(programPath) << workload.generate();
+        std::vector<std::string> command = {code};
+        command.insert(command.end(), extra.begin(), extra.end());
+        command.insert(command.end(), {"--load", programPath, "--run"});
+        long statements = countStatements(command, "bench_suite_profile.txt");
+        std::vector<double> times;
+        long peak = 0;
+        for (int i = 0; i < runs; i++) {
+            Sample sample = runOnce(command);
+            times.push_back(sample.seconds);
+            peak = std::max(peak, sample.peakRssKb);
+        }
+        std::sort(times.begin(), times.end());
+        Result r{workload.name, percentile(times, 0.5), percentile(times, 0.9), times.front(), times.back(),
+                 statements, 0, peak};
+        r.statementsPerSecond = double(statements) / r.median;
+        results.push_back(r);
+        std::printf("%-17s %8.3fs %8.3fs %8.3fs %12ld %12.3g %7ld KB\n",
+                    r.name.c_str(), r.median, r.p90, r.min, r.statements, r.statementsPerSecond, r.peakRssKb);
+    }
+    std::remove(programPath.c_str());
+    std::string host = hostKey();
+    writeJson(results, host, output);
+    std::cout << "results written to " << output << "\n";
+
+    if (baseline.empty()) return 0;
+    std::string recorded;
+    std::map<std::string, double> base;
+    if (!readBaseline(baseline, recorded, base) || recorded != host) {
+        if (!only.empty()) {   //只有完整的一次运行才记录为基线
+            std::cout << "no baseline for this host in " << baseline << "; nothing compared\n";
+            return 0;
+        }
+        writeJson(results, host, baseline);
+        std::cout << "no baseline for this host; this run is recorded as the baseline in " << baseline << "\n";
+        return 0;
+    }
+    int regressions = 0;
+    for (const Result &r: results) {
+        auto it = base.find(r.name);
+        if (it == base.end() || it->second <= 0) continue;
+        double change = 100.0 * (r.median - it->second) / it->second;
+        bool regressed = change > threshold;
+        regressions += regressed;
+        std::printf("%-17s %8.3fs vs baseline %8.3fs  %+6.1f%%%s\n", r.name.c_str(), r.median, it->second, change,
+                    regressed ? "  REGRESSION" : "");
+    }
+    std::printf("%d regression(s) beyond %.1f%%%s\n", regressions, threshold,
+                regressions != 0 && !strict ? " (advisory; --strict fails on them)" : "");
+    return regressions != 0 && strict ? 1 : 0;
+}
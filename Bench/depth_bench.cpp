@@ -0,0 +1,68 @@
+/*
+ * File: depth_bench.cpp
+ * ---------------------
+ * Expression-depth stress benchmark.  For growing depths it builds a
+ * left-nested chain ((((a + 1) + 1) ...) and a right-nested chain
+ * a + (a + (a + ...)), then reports the time per evaluation and per
+ * node.  A single-pass evaluator keeps ns/node flat as depth grows.
+ *
+ * Usage: depth_bench [max_depth]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "parser.hpp"
+
+static std::string leftNested(int depth) {
+    std::string source = "a";
+    for (int i = 0; i < depth; i++) source = "(" + source + " + 1)";
+    return source;
+}
+
+static std::string rightNested(int depth) {
+    std::string source = "a";
+    for (int i = 0; i < depth; i++) source = "a + (" + source + ")";
+    return source;
+}
+
+static volatile long sink;
+
+static double timeEval(const std::string &source, EvalState &state) {
+    TokenScanner scanner;
+    scanner.ignoreWhitespace();
+    scanner.scanNumbers();
+    scanner.setInput(source);
+    Expression *exp = parseExp(scanner);
+    exp->resolve(state);
+    EvalStatus status = EVAL_OK;
+    long iterations = 0;
+    long checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    while (elapsed < 2e7) {   //每个用例至少测 20ms
+        for (int i = 0; i < 256; i++) checksum += exp->eval_not_delete(state, status);
+        iterations += 256;
+        elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+    delete exp;
+    sink = checksum;
+    return elapsed / iterations;
+}
+
+int main(int argc, char **argv) {
+    int maxDepth = argc > 1 ? std::atoi(argv[1]) : 1024;
+    EvalState state;
+    state.setValue("a", 1);
+    std::cout << "depth  nodes   left ns/eval  left ns/node  right ns/eval  right ns/node\n";
+    for (int depth = 1; depth <= maxDepth; depth *= 2) {
+        int nodes = 2 * depth + 1;
+        double left = timeEval(leftNested(depth), state);
+        double right = timeEval(rightNested(depth), state);
+        std::cout << depth << "  " << nodes
+                  << "  " << left << "  " << left / nodes
+                  << "  " << right << "  " << right / nodes << "\n";
+    }
+    return 0;
+}
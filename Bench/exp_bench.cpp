@@ -0,0 +1,58 @@
+/*
+ * File: exp_bench.cpp
+ * -------------------
+ * Micro-benchmark for the expression evaluator.  Each test expression
+ * is parsed once and then evaluated repeatedly with eval_not_delete;
+ * the report gives the time per evaluation and per tree node.
+ *
+ * Usage: exp_bench [iterations]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "parser.hpp"
+
+static int countNodes(Expression *exp) {
+    if (exp->getType() != COMPOUND) return 1;
+    auto *compound = (CompoundExp *) exp;
+    return 1 + countNodes(compound->getLHS()) + countNodes(compound->getRHS());
+}
+
+static void runCase(const std::string &source, EvalState &state, long iterations) {
+    TokenScanner scanner;
+    scanner.ignoreWhitespace();
+    scanner.scanNumbers();
+    scanner.setInput(source);
+    Expression *exp = parseExp(scanner);
+    exp->resolve(state);
+    int nodes = countNodes(exp);
+    EvalStatus status = EVAL_OK;
+    long checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; i++) {
+        checksum += exp->eval_not_delete(state, status);
+    }
+    auto stop = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    std::cout << source << "\n    nodes " << nodes
+              << "  ns/eval " << ns / iterations
+              << "  ns/node " << ns / iterations / nodes
+              << "  (checksum " << checksum << ")\n";
+    delete exp;
+}
+
+int main(int argc, char **argv) {
+    long iterations = argc > 1 ? std::atol(argv[1]) : 2000000;
+    EvalState state;
+    state.setValue("a", 7);
+    state.setValue("b", 3);
+    state.setValue("c", 11);
+    runCase("a + b", state, iterations);
+    runCase("a * b - c / 3", state, iterations);
+    runCase("(a + 1) * (b - 2) + c * (a - b) / 2", state, iterations);
+    runCase("a + b + c + a + b + c + a + b + c + a + b + c", state, iterations);
+    runCase("((((a + 1) * 2 - b) * 3 + c) / 2 - a) * (b + c)", state, iterations);
+    return 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * File: load_bench.cpp
+ * --------------------
+ * Program loading benchmark.  Writes a generated BASIC program of the
+ * requested size, then times the interpreter loading it through
+ * `code --load` and, for comparison, through stdin.  Both runs read the
+ * program and stop without running it.  The report gives lines/second.
+ *
+ * Usage: load_bench path/to/code [lines]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+static void writeProgram(const std::string &path, long lines) {
+    std::ofstream out(path);
+    for (long i = 1; i <= lines; i++) {
+        out << i * 10;
+        switch (i % 4) {
+            case 0: out << " LET v" << i % 97 << " = (a + " << i << ") * 3 - b / 7\n"; break;
+            case 1: out << " PRINT v" << i % 97 << " + " << i << "\n"; break;
+            case 2: out << " IF v" << i % 97 << " > " << i << " THEN " << (i + 2) * 10 << "\n"; break;
+            default: out << " REM line " << i << "\n"; break;
+        }
+    }
+}
+
+static double timeCommand(const std::string &command) {
+    auto start = std::chrono::steady_clock::now();
+    if (std::system(command.c_str()) != 0) {
+        std::cerr << "command failed: " << command << "\n";
+        std::exit(1);
+    }
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(stop - start).count();
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "usage: load_bench path/to/code [lines]\n";
+        return 1;
+    }
+    std::string code = argv[1];
+    long lines = argc > 2 ? std::atol(argv[2]) : 1000000;
+    std::string path = "load_bench_program.bas";
+    writeProgram(path, lines);
+    double mapped = timeCommand(code + " --load " + path + " < /dev/null > /dev/null");
+    double piped = timeCommand(code + " < " + path + " > /dev/null");
+    std::cout << lines << " lines\n";
+    std::cout << "--load: " << mapped << " s, " << lines / mapped << " lines/s\n";
+    std::cout << "stdin:  " << piped << " s, " << lines / piped << " lines/s\n";
+    std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * File: profile_bench.cpp
+ * -----------------------
+ * Profiler overhead benchmark.  Runs a few loop-heavy BASIC programs
+ * with the profiler off, through both the default engine and the tree
+ * interpreter, and once with PROFILE ON.  Given a second executable
+ * built without the profiler, it runs that too, so that the "off"
+ * columns can be compared with a baseline: the disabled profiler
+ * should be within the noise of it.
+ *
+ * Each configuration runs five times; the report gives the median
+ * wall time, which includes loading the program.
+ *
+ * Usage: profile_bench path/to/code [path/to/baseline-code]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct Workload {
+    const char *name;
+    const char *source;
+};
+
+static const Workload WORKLOADS[] = {
+    {"count", "10 LET i = 0\n"
+              "20 LET i = i + 1\n"
+              "30 IF i < 20000000 THEN 20\n"},
+    {"arith", "10 LET i = 0\n"
+              "20 LET s = 0\n"
+              "30 LET s = s + i * 3 - i / 7\n"
+              "40 LET t = (s - i) * 2 + 1\n"
+              "50 LET i = i + 1\n"
+              "60 IF i < 5000000 THEN 30\n"},
+    {"goto", "10 LET i = 0\n"
+             "20 GOTO 40\n"
+             "30 GOTO 60\n"
+             "40 LET i = i + 1\n"
+             "50 GOTO 30\n"
+             "60 IF i = 10000000 THEN 80\n"
+             "70 GOTO 20\n"
+             "80 REM done\n"},
+};
+
+static double medianRun(const std::string &command) {
+    std::vector<double> times;
+    for (int i = 0; i < 5; i++) {
+        auto start = std::chrono::steady_clock::now();
+        if (std::system(command.c_str()) != 0) {
+            std::cerr << "command failed: " << command << "\n";
+            std::exit(1);
+        }
+        times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+static void report(const char *label, double value, double baseline) {
+    std::printf("  %-22s %8.3f s", label, value);
+    if (baseline > 0) std::printf("   %+6.1f%% vs baseline", 100.0 * (value - baseline) / baseline);
+    std::printf("\n");
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "usage: profile_bench path/to/code [path/to/baseline-code]\n";
+        return 1;
+    }
+    std::string code = argv[1];
+    std::string baseline = argc > 2 ? argv[2] : "";
+    std::string plain = "profile_bench_program.bas";
+    std::string profiled = "profile_bench_profiled.bas";
+    for (const Workload &workload: WORKLOADS) {
+        std::ofstream(plain) << workload.source << "RUN\n";
+        std::ofstream(profiled) << workload.source << "PROFILE ON\nRUN\n";
+        std::printf("%s (median of 5)\n", workload.name);
+        double baseDefault = 0, baseTree = 0;
+        if (!baseline.empty()) {
+            baseDefault = medianRun(baseline + " < " + plain + " > /dev/null");
+            baseTree = medianRun(baseline + " --tree < " + plain + " > /dev/null");
+            report("baseline", baseDefault, 0);
+            report("baseline --tree", baseTree, 0);
+        }
+        report("profiler off", medianRun(code + " < " + plain + " > /dev/null"), baseDefault);
+        report("profiler off, --tree", medianRun(code + " --tree < " + plain + " > /dev/null"), baseTree);
+        report("PROFILE ON", medianRun(code + " < " + profiled + " > /dev/null"), baseTree);
+    }
+    std::remove(plain.c_str());
+    std::remove(profiled.c_str());
+    return 0;
+}
@@ -0,0 +1,146 @@
+/*
+ * File: strlib_bench.cpp
+ * ----------------------
+ * Integer conversion benchmark.  Times stringToInteger and
+ * integerToString against the <sstream> versions they replaced, for
+ * numbers of typical widths: line numbers and small constants, five
+ * digit values, full ten digit values and negative numbers.
+ *
+ * Before timing, both parsers are run over a set of edge cases and
+ * random strings of digits, signs and whitespace; they must accept the
+ * same strings, return the same values and fail with the same message.
+ *
+ * Usage: strlib_bench [iterations]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Utils/error.hpp"
+#include "Utils/strlib.hpp"
+
+/* The <sstream> versions, kept as the reference */
+
+static std::string streamIntegerToString(int n) {
+    std::ostringstream stream;
+    stream << n;
+    return stream.str();
+}
+
+static int streamStringToInteger(std::string str) {
+    std::istringstream stream(str);
+    int value;
+    stream >> value;
+    if (!stream.eof()) stream >> std::ws;
+    if (stream.fail() || !stream.eof()) {
+        error("stringToInteger: Illegal integer format (" + str + ")");
+    }
+    return value;
+}
+
+// 返回值或错误信息，用来比较两种实现
+template<typename Parse>
+static std::string outcome(Parse parse, const std::string &text) {
+    try {
+        return std::to_string(parse(text));
+    } catch (ErrorException &ex) {
+        return ex.getMessage();
+    }
+}
+
+static long checkParsers() {
+    std::vector<std::string> cases = {
+            "", " ", "0", "-0", "+0", "+", "-", "+-1", "-+1", "++1", "--1", "+ 1", "- 1",
+            "12", " 12", "12 ", "\t12\n", "\v12\f", "\r12\r", "1 2", "12a", "a12", "0x10", "1e3", "1.5",
+            "2147483647", "2147483648", "-2147483648", "-2147483649", "00000000000000000000042",
+            "99999999999999999999999", std::string("1\0", 2), "１２",
+    };
+    std::mt19937 random(42);
+    const char alphabet[] = " \t\n+-0123456789x.";
+    for (int i = 0; i < 200000; i++) {
+        std::string text;
+        int length = random() % 14;
+        for (int j = 0; j < length; j++) {
+            text += random() % 4 == 0 ? alphabet[random() % (sizeof alphabet - 1)] : char('0' + random() % 10);
+        }
+        cases.push_back(text);
+        cases.push_back(std::to_string(int(random())));
+    }
+    long mismatches = 0;
+    for (const std::string &text: cases) {
+        std::string expected = outcome(streamStringToInteger, text);
+        std::string actual = outcome([](const std::string &s) { return stringToInteger(s); }, text);
+        if (expected != actual) {
+            if (mismatches++ < 10) std::cerr << "mismatch on \"" << text << "\": " << expected << " vs " << actual << "\n";
+        }
+    }
+    for (int i = 0; i < 1000000; i++) {
+        int n = i < 3 ? (i == 0 ? 0 : i == 1 ? 2147483647 : -2147483647 - 1) : int(random());
+        if (streamIntegerToString(n) != integerToString(n)) mismatches++;
+    }
+    return mismatches;
+}
+
+static std::vector<std::string> numbers(int digits, bool negative) {
+    std::mt19937 random(digits);
+    std::vector<std::string> result;
+    for (int i = 0; i < 1024; i++) {
+        std::string text = negative ? "-" : "";
+        text += char('1' + random() % 9);
+        for (int j = 1; j < digits; j++) text += char('0' + random() % 10);
+        if (digits == 10) text[negative] = '1';   //保证十位数不超出 int
+        result.push_back(text);
+    }
+    return result;
+}
+
+template<typename Function>
+static double nanoseconds(long iterations, Function function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / double(iterations);
+}
+
+int main(int argc, char **argv) {
+    long iterations = argc > 1 ? std::atol(argv[1]) : 2000000;
+    long mismatches = checkParsers();
+    std::cout << "semantics check: " << mismatches << " mismatches\n";
+    if (mismatches != 0) return 1;
+
+    struct Width {
+        const char *label;
+        int digits;
+        bool negative;
+    };
+    const Width widths[] = {{"1-3 digits", 2, false}, {"5 digits", 5, false},
+                            {"10 digits", 10, false}, {"negative 6 digits", 6, true}};
+    std::cout << "ns per call          stringToInteger       integerToString\n"
+                 "                     sstream  charconv     sstream  charconv\n";
+    long checksum = 0;
+    for (const Width &width: widths) {
+        std::vector<std::string> texts = numbers(width.digits, width.negative);
+        std::vector<int> values;
+        for (const std::string &text: texts) values.push_back(stringToInteger(text));
+        double parseOld = nanoseconds(iterations, [&] {
+            for (long i = 0; i < iterations; i++) checksum += streamStringToInteger(texts[i & 1023]);
+        });
+        double parseNew = nanoseconds(iterations, [&] {
+            for (long i = 0; i < iterations; i++) checksum += stringToInteger(texts[i & 1023]);
+        });
+        double formatOld = nanoseconds(iterations, [&] {
+            for (long i = 0; i < iterations; i++) checksum += streamIntegerToString(values[i & 1023]).size();
+        });
+        double formatNew = nanoseconds(iterations, [&] {
+            for (long i = 0; i < iterations; i++) checksum += integerToString(values[i & 1023]).size();
+        });
+        std::printf("%-18s %9.1f %9.1f   %9.1f %9.1f\n", width.label, parseOld, parseNew, formatOld, formatNew);
+    }
+    std::cout << "(checksum " << checksum << ")\n";
+    return 0;
+}
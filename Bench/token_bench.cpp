@@ -0,0 +1,75 @@
+/*
+ * File: token_bench.cpp
+ * ---------------------
+ * Tokenizer throughput benchmark.  The Test/ traces are concatenated
+ * and tokenized line by line, the same way processLine feeds the
+ * scanner, for the requested number of passes.  The run is repeated
+ * with a few multicharacter operators registered so that the operator
+ * trie is exercised as well.  The report gives tokens per second.
+ *
+ * Usage: token_bench [test_dir] [passes]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Utils/tokenScanner.hpp"
+
+static std::vector<std::string> loadTraces(const std::string &dir) {
+    std::vector<std::string> lines;
+    for (int i = 0; i < 100; i++) {
+        std::string name = dir + "/trace" + (i < 10 ? "0" : "") + std::to_string(i) + ".txt";
+        std::ifstream in(name);
+        std::string line;
+        while (getline(in, line)) lines.push_back(line);
+    }
+    return lines;
+}
+
+static void run(const char *label, const std::vector<std::string> &lines, long passes, bool operators) {
+    TokenScanner scanner;
+    scanner.ignoreWhitespace();
+    scanner.scanNumbers();
+    if (operators) {
+        scanner.addOperator("<=");
+        scanner.addOperator(">=");
+        scanner.addOperator("<>");
+        scanner.addOperator("**");
+    }
+    long tokens = 0;
+    long checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long pass = 0; pass < passes; pass++) {
+        for (const std::string &line: lines) {
+            scanner.setInputView(line);
+            while (true) {
+                Token token = scanner.nextTokenView();
+                if (token.text.empty()) break;
+                checksum += token.type;
+                tokens++;
+            }
+        }
+    }
+    auto stop = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    std::cout << label << ": " << tokens << " tokens in " << seconds << " s, "
+              << tokens / seconds / 1e6 << " Mtokens/s (checksum " << checksum << ")\n";
+}
+
+int main(int argc, char **argv) {
+    std::string dir = argc > 1 ? argv[1] : "Test";
+    long passes = argc > 2 ? std::atol(argv[2]) : 2000;
+    std::vector<std::string> lines = loadTraces(dir);
+    if (lines.empty()) {
+        std::cerr << "no traces found in " << dir << "\n";
+        return 1;
+    }
+    std::cout << lines.size() << " lines x " << passes << " passes\n";
+    run("single-char operators", lines, passes, false);
+    run("with operator trie   ", lines, passes, true);
+    return 0;
+}
@@ -0,0 +1,72 @@
+#!/bin/bash
+#
+# batch_runs.sh: checks --batch against one run per input set.
+#
+# A program with INPUT is run over a file of input sets with --batch on
+# several threads, and once per set with --data.  The batch output must
+# be the single-run outputs concatenated in the order of the sets, for
+# every engine and with a step limit.  Some sets are short, so that
+# INPUT runs out, and some divide by zero, so that runs stop with an
+# error at different points.  Because of them the batch must exit with
+# status 1; a batch of sets that all succeed must exit with status 0.
+#
+# Usage: batch_runs.sh path/to/code
+
+code=$1
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+cat > "$work/program" <<'BASIC'
+10 INPUT n
+20 INPUT m
+30 LET s = 0
+40 LET i = 0
+50 LET s = s + i * m
+60 LET i = i + 1
+70 IF i < n THEN 50
+80 PRINT s
+90 IF m = 0 THEN 120
+100 PRINT s / m
+110 END
+120 PRINT 1 / m
+BASIC
+
+for k in $(seq 1 60); do
+    case $((k % 7)) in
+        0) echo "$((k * 13))" ;;          # INPUT 取不到第二个值
+        1) echo "$((k * 11)) 0" ;;        # 除以零
+        2) echo "" ;;                     # 空行不算一组
+        *) echo "$((k * 37 % 500 + 1)) $((k % 5 - 2))" ;;
+    esac
+done > "$work/sets"
+
+failed=0
+for options in "" "--no-jit" "--tree" "--max-steps 900"; do
+    : > "$work/expected"
+    while read -r line; do
+        [ -z "$line" ] && continue
+        echo "$line" > "$work/one"
+        "$code" $options --no-prompt --data "$work/one" --load "$work/program" --run \
+            < /dev/null >> "$work/expected" 2> /dev/null
+    done < "$work/sets"
+    "$code" $options --no-prompt --batch "$work/sets" --threads 4 --load "$work/program" \
+        < /dev/null > "$work/actual"
+    if [ $? -ne 1 ]; then
+        echo "batch with failing sets does not exit with 1, options '$options'"
+        failed=$((failed + 1))
+    fi
+    if ! diff "$work/expected" "$work/actual" > "$work/diff"; then
+        echo "batch output differs with options '$options'"
+        cat "$work/diff"
+        failed=$((failed + 1))
+    fi
+done
+
+printf '5 3\n7 1\n' > "$work/good"
+if ! "$code" --no-prompt --batch "$work/good" --load "$work/program" < /dev/null > /dev/null; then
+    echo "batch of successful sets does not exit with 0"
+    failed=$((failed + 1))
+fi
+
+echo "$failed configurations failed"
+[ "$failed" -eq 0 ]
@@ -0,0 +1,52 @@
+#!/bin/bash
+#
+# compile_traces.sh: checks COMPILE against the interpreter.
+#
+# For every trace that contains RUN, the program as it stands at the
+# first RUN is translated with COMPILE and built with the C++ compiler,
+# which must not warn under -Wall.
+# The lines after RUN, up to the next command, are the INPUT values.
+# The executable must print exactly what the interpreter prints for
+# the same program, on a fresh state, with the same input.
+#
+# Usage: compile_traces.sh path/to/code c++-compiler trace-dir
+
+code=$1
+cxx=$2
+traces=$3
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+marker=1234567890
+commands='^(REM|LET|PRINT|INPUT|END|GOTO|IF|RUN|LIST|CLEAR|QUIT|HELP|COMPILE)( |$)|^[0-9]+ +[A-Z]'
+checked=0
+failed=0
+for trace in "$traces"/trace*.txt; do
+    name=$(basename "$trace" .txt)
+    tr -d '\r' < "$trace" > "$work/session"
+    grep -qx 'RUN' "$work/session" || continue
+    # 第一个 RUN 之前改动程序的行：带行号的行和 CLEAR
+    awk '$0 == "RUN" { exit } /^[0-9]/ || $0 == "CLEAR"' "$work/session" > "$work/program"
+    awk -v cmd="$commands" 'found && $0 ~ cmd { exit } found { print } $0 == "RUN" { found = 1 }' \
+        "$work/session" > "$work/input"
+
+    { cat "$work/program"; echo "COMPILE $work/$name.cpp"; echo "QUIT"; } | "$code" > /dev/null
+    if ! "$cxx" -O1 -Wall -Werror -o "$work/$name" "$work/$name.cpp" 2> "$work/cxx.log"; then
+        echo "$name: generated source does not compile"
+        cat "$work/cxx.log"
+        failed=$((failed + 1))
+        continue
+    fi
+    { cat "$work/program"; echo "PRINT $marker"; echo "RUN"; cat "$work/input"; } | "$code" \
+        | awk -v marker="$marker" 'seen { print } $0 == marker { seen = 1 }' > "$work/expected"
+    timeout 10 "$work/$name" < "$work/input" > "$work/actual"
+    if ! diff "$work/expected" "$work/actual" > "$work/diff"; then
+        echo "$name: output differs from the interpreter"
+        cat "$work/diff"
+        failed=$((failed + 1))
+    fi
+    checked=$((checked + 1))
+done
+
+echo "$checked traces compiled, $failed failed"
+[ "$checked" -gt 0 ] && [ "$failed" -eq 0 ]
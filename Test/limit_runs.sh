@@ -0,0 +1,59 @@
+#!/bin/bash
+#
+# limit_runs.sh: checks the step limit of the VM and the JIT against
+# the tree interpreter.
+#
+# Every trace is run with a range of step limits under each engine.
+# The output, the limit message and the progress line on stderr (the
+# line about to run and the statements executed; the milliseconds are
+# left out) must be those of the tree interpreter, which executes one
+# statement per line and is the reference for the step count.
+#
+# A limit that is not a whole number of 0 or more, or is missing, must
+# be rejected with exit status 1 before anything runs, instead of
+# turning the limit off or stopping before the first statement.
+#
+# Usage: limit_runs.sh path/to/code trace-dir
+
+code=$1
+traces=$2
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+checked=0
+failed=0
+for trace in "$traces"/trace*.txt; do
+    name=$(basename "$trace" .txt)
+    tr -d '\r' < "$trace" > "$work/session"
+    for steps in 1 2 3 7 40 1023 1024 1025 5000; do
+        "$code" --tree --max-steps $steps < "$work/session" 2>&1 \
+            | sed 's/, [0-9]* ms$//' > "$work/expected"
+        for engine in "" "--no-jit"; do
+            "$code" $engine --max-steps $steps < "$work/session" 2>&1 \
+                | sed 's/, [0-9]* ms$//' > "$work/actual"
+            if ! diff "$work/expected" "$work/actual" > "$work/diff"; then
+                echo "$name: '$engine --max-steps $steps' differs from the tree interpreter"
+                cat "$work/diff"
+                failed=$((failed + 1))
+            fi
+            checked=$((checked + 1))
+        done
+    done
+done
+
+printf '10 LET a = 1\n20 GOTO 10\n' > "$work/forever"
+for option in --max-steps --max-time; do
+    for value in abc -5 -1 12x "" 1.5 99999999999999999999 MISSING; do
+        [ "$value" = MISSING ] && args=("$option") || args=("$option" "$value")
+        timeout 10 "$code" "${args[@]}" --load "$work/forever" --run < /dev/null > "$work/out" 2> "$work/err"
+        status=$?
+        if [ $status -ne 1 ] || [ -s "$work/out" ] || [ ! -s "$work/err" ]; then
+            echo "'${args[*]}' is not rejected (exit status $status)"
+            failed=$((failed + 1))
+        fi
+        checked=$((checked + 1))
+    done
+done
+
+echo "$checked runs compared, $failed differ"
+[ "$failed" -eq 0 ]
@@ -0,0 +1,197 @@
+/*
+ * File: thread_stress.cpp
+ * -----------------------
+ * Stress test for running one Program from many threads at once.  Two
+ * programs are built in memory, prepared once and then run over and
+ * over by several threads, each with its own copy of the state and its
+ * own output buffer, under every engine: the tree interpreter, the
+ * bytecode VM, the JIT and the limited (instrumented) loop.  Every run
+ * must print exactly what a single-threaded run under the tree
+ * interpreter prints, including the message of a run stopped by an
+ * error.  The same is checked for an expression evaluated from many
+ * threads after it has failed.
+ *
+ * Usage: thread_stress [runs-per-thread]
+ *
+ * The test is meant to be run under ThreadSanitizer as well:
+ *
+ *     cmake -S . -B tsan -DBASIC_SANITIZE_THREAD=ON
+ *     cmake --build tsan --target thread_stress && tsan/thread_stress
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "inputdata.hpp"
+#include "output.hpp"
+#include "parser.hpp"
+#include "program.hpp"
+#include "statement.hpp"
+
+static const int THREADS = 8;
+
+static Expression *parseText(const std::string &text) {
+    TokenScanner scanner;
+    scanner.ignoreWhitespace();
+    scanner.scanNumbers();
+    scanner.setInput(text);
+    return parseExp(scanner);
+}
+
+static IfStatement *makeIf(const std::string &lhs, std::string_view op, const std::string &rhs, int target) {
+    return new IfStatement(makeComparisonExp(op, parseText(lhs), parseText(rhs)), target);
+}
+
+static void addLine(Program &program, EvalState &state, int line, Statement *stmt) {
+    stmt->resolve(state);
+    program.addParsedLine(line, std::to_string(line), stmt);
+}
+
+/*
+ * Program A reads N, prints the sum of the first N squares and then
+ * divides by N - 7, so that N = 7 stops with DIVIDE BY ZERO, N > 9
+ * jumps to a missing line and an empty set runs out of INPUT data.
+ * Program B has no INPUT, so the JIT takes it; it counts the steps of
+ * the Collatz sequence from 27 and then prints an undefined variable.
+ */
+
+static void buildInputProgram(Program &program, EvalState &state) {
+    addLine(program, state, 10, new InputStatement("N"));
+    addLine(program, state, 20, new LetStatement(parseText("0"), "S"));
+    addLine(program, state, 30, new LetStatement(parseText("1"), "I"));
+    addLine(program, state, 40, new LetStatement(parseText("S + I * I"), "S"));
+    addLine(program, state, 50, new LetStatement(parseText("I + 1"), "I"));
+    addLine(program, state, 60, makeIf("I", "<", "N + 1", 40));
+    addLine(program, state, 70, new PrintStatement(parseText("S")));
+    addLine(program, state, 80, new LetStatement(parseText("100 / (N - 7)"), "Q"));
+    addLine(program, state, 90, new PrintStatement(parseText("Q")));
+    addLine(program, state, 100, makeIf("N", ">", "9", 999));
+    addLine(program, state, 110, new EndStatement());
+}
+
+static void buildLoopProgram(Program &program, EvalState &state) {
+    addLine(program, state, 10, new LetStatement(parseText("27"), "X"));
+    addLine(program, state, 20, new LetStatement(parseText("0"), "C"));
+    addLine(program, state, 30, makeIf("X", "=", "1", 90));
+    addLine(program, state, 40, new LetStatement(parseText("X / 2"), "H"));
+    addLine(program, state, 50, makeIf("H * 2", "=", "X", 80));
+    addLine(program, state, 60, new LetStatement(parseText("3 * X + 1"), "X"));
+    addLine(program, state, 70, new GotoStatement(85));
+    addLine(program, state, 80, new LetStatement(parseText("H"), "X"));
+    addLine(program, state, 85, new LetStatement(parseText("C + 1"), "C"));
+    addLine(program, state, 87, new GotoStatement(30));
+    addLine(program, state, 90, new PrintStatement(parseText("C")));
+    addLine(program, state, 95, new PrintStatement(parseText("Z")));
+}
+
+static std::string runOnce(const Program &program, const EvalState &state, const std::vector<int> &values) {
+    EvalState local = state;
+    InputData data(values);
+    local.setInputData(&data);
+    std::string text;
+    {
+        OutputBuffer buffer(text);
+        OutputScope scope(buffer);
+        RunStats stats;
+        try {
+            EvalStatus status = program.run(local, stats);
+            if (status != EVAL_OK) output().printLine(statusMessage(status));
+        } catch (ErrorException &ex) {
+            output().printLine(ex.getMessage());
+        }
+    }
+    return text;
+}
+
+static int stressProgram(const char *name, void (*build)(Program &, EvalState &),
+                         const std::vector<std::vector<int>> &sets, int runs) {
+    std::vector<std::string> expected;
+    {
+        Program program;
+        EvalState state;
+        build(program, state);
+        program.setBytecodeEnabled(false);
+        program.prepare();
+        for (const std::vector<int> &values: sets) expected.push_back(runOnce(program, state, values));
+    }
+
+    struct Engine {
+        const char *name;
+        void (*configure)(Program &);
+    };
+    const Engine engines[] = {
+            {"tree",    [](Program &program) { program.setBytecodeEnabled(false); }},
+            {"vm",      [](Program &program) { program.setJitEnabled(false); }},
+            {"jit",     [](Program &) {}},
+            {"limited", [](Program &program) { program.setLimits(5000, 0); }},
+    };
+
+    int failures = 0;
+    for (const Engine &engine: engines) {
+        Program program;
+        EvalState state;
+        build(program, state);
+        engine.configure(program);
+        program.prepare();
+        const Program &shared = program;
+
+        std::atomic<int> mismatches{0};
+        std::vector<std::thread> pool;
+        for (int t = 0; t < THREADS; t++) {
+            pool.emplace_back([&, t] {
+                for (int r = 0; r < runs; r++) {
+                    size_t i = size_t(t + r) % sets.size();   //各线程错开输入组
+                    if (runOnce(shared, state, sets[i]) != expected[i]) mismatches++;
+                }
+            });
+        }
+        for (std::thread &thread: pool) thread.join();
+        if (mismatches != 0) {
+            std::cerr << name << " (" << engine.name << "): " << mismatches
+                      << " of " << THREADS * runs << " runs differ" << std::endl;
+            failures++;
+        }
+    }
+    return failures;
+}
+
+static int stressExpression(int runs) {
+    EvalState state;
+    state.setValue("A", 6);
+    Expression *exp = parseText("A * A / (A - 6) + B");   //DIVIDE BY ZERO，之后树必须完好
+    exp->resolve(state);
+    EvalStatus first = EVAL_OK;
+    int value = exp->eval_not_delete(state, first);
+    std::atomic<int> mismatches{0};
+    std::vector<std::thread> pool;
+    for (int t = 0; t < THREADS; t++) {
+        pool.emplace_back([&] {
+            for (int r = 0; r < runs; r++) {
+                EvalStatus status = EVAL_OK;
+                if (exp->eval_not_delete(state, status) != value || status != first) mismatches++;
+            }
+        });
+    }
+    for (std::thread &thread: pool) thread.join();
+    delete exp;
+    if (first == EVAL_OK || mismatches != 0) {
+        std::cerr << "expression: " << mismatches << " of " << THREADS * runs
+                  << " evaluations differ" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    int runs = (argc > 1) ? std::atoi(argv[1]) : 200;
+    int failures = 0;
+    failures += stressProgram("input", buildInputProgram, {{3}, {7}, {12}, {}, {5}, {9}, {1}}, runs);
+    failures += stressProgram("loop", buildLoopProgram, {{}}, runs);
+    failures += stressExpression(runs * 10);
+    if (failures != 0) return 1;
+    std::cout << "thread_stress: all runs agree" << std::endl;
+    return 0;
+}
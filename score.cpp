@@ -1,5 +1,17 @@
 #include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
 #include <cstdlib>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 using namespace std;
@@ -26,17 +38,19 @@ string studentBasic = "";
 string standerBasic = "";
 string traceFile = "";
 int runTraces = traceCount, currentTrace = 0;
+int jobs = 0;   // -j N：并行跑 trace 的进程数，0 表示原来的顺序模式
 bool silent = false, firstFail = false, hideError = false, useColor = true;
 
 int correct = 0, wrong = 0, total = 0;
 
 void useage(const char *progname) {
     cout
-            << progname << " [-h] [-e <your_exec>] [-s <stander_exec>] [-t <trace_file>] [-f] [-m] [-q]" << endl
+            << progname << " [-h] [-e <your_exec>] [-s <stander_exec>] [-t <trace_file>] [-j <jobs>] [-f] [-m] [-q]" << endl
             << "    -h  Show this message and quit" << endl
             << "    -e  Specify your executable file, default value: " << defaultStudentBasic << endl
             << "    -s  Specify demo executable file, default value: " << defaultStanderBasic << endl
             << "    -t  Run specified trace file" << endl
+            << "    -j  Run traces on <jobs> parallel workers, reporting per-trace wall time" << endl
             << "    -f  Stop at first failed test" << endl
             << "    -m  Hide error message" << endl
             << "    -q  Show final score only, cannot use with -t or -f, include -m" << endl;
@@ -51,7 +65,7 @@ string color(string ce) {
 void parseArguments(int argc, char **argv) {
     int c;
     opterr = 0;
-    while ((c = getopt(argc, argv, "e:s:t:fmqch")) != -1) {
+    while ((c = getopt(argc, argv, "e:s:t:j:fmqch")) != -1) {
         switch (c) {
             case 'e':
                 if (studentBasic.size()) useage(argv[0]);
@@ -65,6 +79,11 @@ void parseArguments(int argc, char **argv) {
                 if (traceFile.size()) useage(argv[0]);
                 traceFile = optarg;
                 break;
+            case 'j':
+                if (jobs) useage(argv[0]);
+                jobs = atoi(optarg);
+                if (jobs <= 0) useage(argv[0]);
+                break;
             case 'f':
                 if (firstFail) useage(argv[0]);
                 firstFail = true;
@@ -106,6 +125,30 @@ int testTrace(const char *trace) {
     return 0;
 }
 
+string readFile(const string &path) {
+    ifstream in(path);
+    stringstream content;
+    content << in.rdbuf();
+    return content.str();
+}
+
+void showFailure(const string &trace, int error, const string &demoOutput, const string &yourOutput) {
+    cout << "Trace file: " << endl << color("\x1b[35m");
+    cout << readFile(trace);
+    cout << color("\x1b[0m") << endl;
+    if (error == 1) cout << color("\x1b[31m") << "Error occurred while running demo program" << color("\x1b[0m") << endl;
+    if (error == 2) cout << color("\x1b[31m") << "Error occurred while running your program" << color("\x1b[0m") << endl;
+    if (error == 3) cout << color("\x1b[31m") << "Memory leak" << color("\x1b[0m") << endl;
+    if (error == 4) {
+        cout << "Demo output: " << endl << color("\x1b[36m");
+        cout << demoOutput;
+        cout << color("\x1b[0m") << endl;
+        cout << "Your output: " << endl << color("\x1b[33m");
+        cout << yourOutput;
+        cout << color("\x1b[0m") << endl;
+    }
+}
+
 void runTest(const string currentTrace) {
     if (!silent) cout << "Trace \"" << currentTrace << "\" ... ";
     cout.flush();
@@ -118,34 +161,155 @@ void runTest(const string currentTrace) {
         wrong++;
         if (!silent) {
             cout << color("\x1b[31;1m") << "Fail" << color("\x1b[0m") << endl;
-            if (!hideError) {
-                cout << "Trace file: " << endl << color("\x1b[35m");
-                cout.flush();
-                int r0 = system((string() + "cat " + currentTrace).c_str());
-                (void) r0;
-                cout << color("\x1b[0m") << endl;
-                if (error == 1) cout << color("\x1b[31m") << "Error occurred while running demo program" << color("\x1b[0m") << endl;
-                if (error == 2) cout << color("\x1b[31m") << "Error occurred while running your program" << color("\x1b[0m") << endl;
-                if (error == 3) cout << color("\x1b[31m") << "Memory leak" << color("\x1b[0m") << endl;
-                if (error == 4) {
-                    cout << "Demo output: " << endl << color("\x1b[36m");
-                    cout.flush();
-                    int r1 = system("cat test_ans");
-                    (void) r1;
-                    cout << color("\x1b[0m") << endl;
-                    cout << "Your output: " << endl << color("\x1b[33m");
-                    cout.flush();
-                    int r2 = system("cat test_out");
-                    (void) r2;
-                    cout << color("\x1b[0m") << endl;
-                }
-            }
+            if (!hideError) showFailure(currentTrace, error, readFile("test_ans"), readFile("test_out"));
         }
         clearTempFiles();
         if (firstFail) throw exception();
     }
 }
 
+/*
+ * Parallel mode (-j N)
+ * --------------------
+ * Each trace is a job: the demo, your program and valgrind run one
+ * after another, started with fork/exec and no shell.  The trace file
+ * is the child's stdin and stdout comes back through a pipe, so jobs
+ * share no files and outputs are compared in memory.  The timeouts of
+ * the sequential mode are kept with alarm(), which survives exec; each
+ * child leads its own process group, which is killed once the child
+ * has exited, so that a leftover grandchild cannot hold the pipe open
+ * past the timeout.
+ * N worker threads take traces in order; the main thread prints each
+ * result as soon as all earlier traces have been printed.
+ */
+
+struct TraceResult {
+    int error = 0;
+    string demoOutput, yourOutput;
+    double seconds = 0;
+    bool done = false;
+};
+
+// 以 inputPath 为标准输入运行 args，stdout 收进 output（为空则丢弃）；正常退出且返回 0 时为 true
+bool runProcess(const vector<string> &args, const string &inputPath, unsigned seconds, string *output) {
+    vector<char *> argv;
+    for (const string &arg: args) argv.push_back(const_cast<char *>(arg.c_str()));
+    argv.push_back(nullptr);
+    int input = open(inputPath.c_str(), O_RDONLY | O_CLOEXEC);
+    int null = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    int pipes[2] = {-1, -1};
+    if (input < 0 || null < 0 || (output && pipe2(pipes, O_CLOEXEC) != 0)) {
+        if (input >= 0) close(input);
+        if (null >= 0) close(null);
+        return false;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {   // 子进程里只做 async-signal-safe 的调用
+        setpgid(0, 0);
+        dup2(input, 0);
+        dup2(output ? pipes[1] : null, 1);
+        dup2(null, 2);
+        alarm(seconds);
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+    close(input);
+    close(null);
+    if (output) close(pipes[1]);
+    if (pid < 0) {
+        if (output) close(pipes[0]);
+        return false;
+    }
+    setpgid(pid, pid);
+    int status = 0;
+    bool exited = false;
+    if (output) {
+        // 读到 EOF 为止；主进程退出后杀掉整个进程组，免得遗留的子进程一直占着管道
+        output->clear();
+        pollfd ready = {pipes[0], POLLIN, 0};
+        char buffer[4096];
+        while (true) {
+            if (poll(&ready, 1, 50) > 0) {
+                ssize_t n = read(pipes[0], buffer, sizeof buffer);
+                if (n <= 0) break;
+                output->append(buffer, n);
+                continue;
+            }
+            if (!exited && waitpid(pid, &status, WNOHANG) == pid) {
+                exited = true;
+                kill(-pid, SIGKILL);
+            }
+        }
+        close(pipes[0]);
+    }
+    if (!exited) waitpid(pid, &status, 0);
+    kill(-pid, SIGKILL);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int testTraceParallel(const string &trace, TraceResult &result) {
+    if (!runProcess({standerBasic}, trace, 1, &result.demoOutput)) return 1;
+    if (!runProcess({studentBasic}, trace, 1, &result.yourOutput)) return 2;
+    if (result.demoOutput != result.yourOutput) return 4;
+    if (!runProcess({"valgrind", "--error-exitcode=2", "--leak-check=full", studentBasic}, trace, 5, nullptr)) return 3;
+    return 0;
+}
+
+void runParallel(const vector<string> &traceList) {
+    vector<TraceResult> results(traceList.size());
+    mutex lock;
+    condition_variable finished;
+    size_t next = 0;
+    bool stop = false;
+    auto worker = [&]() {
+        while (true) {
+            size_t i;
+            {
+                lock_guard<mutex> guard(lock);
+                if (stop || next == traceList.size()) return;
+                i = next++;
+            }
+            TraceResult result;
+            auto start = chrono::steady_clock::now();
+            result.error = testTraceParallel(traceList[i], result);
+            result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            result.done = true;
+            lock_guard<mutex> guard(lock);
+            results[i] = move(result);
+            finished.notify_all();
+        }
+    };
+    vector<thread> workers;
+    for (int i = 0; i < jobs; i++) workers.emplace_back(worker);
+    bool failedFirst = false;
+    for (size_t i = 0; i < traceList.size() && !failedFirst; i++) {
+        unique_lock<mutex> guard(lock);
+        finished.wait(guard, [&]() { return results[i].done; });
+        TraceResult result = move(results[i]);
+        guard.unlock();
+        total++;
+        if (!silent) cout << "Trace \"" << traceList[i] << "\" ... ";
+        if (!result.error) {
+            correct++;
+            if (!silent) cout << color("\x1b[32;1m") << "Pass" << color("\x1b[0m");
+        } else {
+            wrong++;
+            if (!silent) cout << color("\x1b[31;1m") << "Fail" << color("\x1b[0m");
+        }
+        if (!silent) {
+            cout << " (" << fixed << setprecision(3) << result.seconds << defaultfloat << " s)" << endl;
+            if (result.error && !hideError) showFailure(traceList[i], result.error, result.demoOutput, result.yourOutput);
+        }
+        if (result.error && firstFail) {
+            lock_guard<mutex> stopGuard(lock);
+            stop = true;
+            failedFirst = true;
+        }
+    }
+    for (thread &t: workers) t.join();
+    if (failedFirst) throw exception();
+}
+
 void showScore() {
     int score = correct / 5 * 5;
     if (!silent)
@@ -157,7 +321,12 @@ void showScore() {
 int main(int argc, char **argv) {
     parseArguments(argc, argv);
     try {
-        if (traceFile.size()) runTest(traceFile);
+        if (jobs) {
+            vector<string> traceList;
+            if (traceFile.size()) traceList.push_back(traceFile);
+            else for (int i = 0; i < traceCount; i++) traceList.push_back(traceFolder + traces[i]);
+            runParallel(traceList);
+        } else if (traceFile.size()) runTest(traceFile);
         else {
             int i = 0;
             for (; i < traceCount; i++) runTest(traceFolder + traces[i]);//   原： for (; i < traceCount; i++)